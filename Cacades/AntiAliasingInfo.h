@@ -4,42 +4,39 @@
 
 struct AntiAliasingInfo
 {
-	GLsizei Samples = 8;
-	GLsizei ActiveSamples = 8;
-	GLsizei MaxSamples;
-	GLuint ColorBuffer;
-	GLuint DepthBuffer;
+	// Requested MSAA samples, 0 disables multisampling
+	GLsizei Samples = 4;
+	// Samples of the scene render target, Samples clamped to MaxSamples
+	GLsizei ActiveSamples = 4;
+	GLsizei MaxSamples = 0;
+	// Post process edge smoothing, a cheap alternative to MSAA
+	bool Fxaa = false;
 
 	void Init()
 	{
-		glGenRenderbuffers(1, &ColorBuffer);
-		glGenRenderbuffers(1, &DepthBuffer);
-
-
-		if (GLEW_NV_framebuffer_multisample_coverage)
-		{
-			int maxModes;
-			glGetIntegerv(GL_MAX_MULTISAMPLE_COVERAGE_MODES_NV, &maxModes);
-			if (maxModes != 0)
-			{
-				int* modes = new int[2 * maxModes];
-				glGetIntegerv(GL_MULTISAMPLE_COVERAGE_MODES_NV, modes);
-
-				MaxSamples = modes[2 * (maxModes - 1)];
-				return;
-			}
-		}
+		glGetIntegerv(GL_MAX_SAMPLES, &MaxSamples);
+		ActiveSamples = Samples < MaxSamples ? Samples : MaxSamples;
+	}
 
-		MaxSamples = 16;
+	// Cycles through 0, 2, 4, ... MaxSamples
+	void NextSampleCount()
+	{
+		Samples = Samples == 0 ? 2 : Samples * 2;
+		if (Samples > MaxSamples)
+			Samples = 0;
+		ActiveSamples = Samples;
 	}
 
 	std::string ParseAAMode() const
 	{
-		if (Samples == 0)
+		if (ActiveSamples <= 1 && !Fxaa)
 			return "Deaktiviert";
 
 		std::stringstream ss;
-		ss << ActiveSamples << "x MSAA";
+		if (ActiveSamples > 1)
+			ss << ActiveSamples << "x MSAA" << (Fxaa ? " + " : "");
+		if (Fxaa)
+			ss << "FXAA";
 		return ss.str();
 	}
 };
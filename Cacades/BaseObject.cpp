@@ -1,12 +1,13 @@
 #include "BaseObject.h"
 #include <GLFW/glfw3.h>
 #include "BasePath.h"
+#include "DensityField.h"
 
 BaseObject::BaseObject(glm::vec3 position) : BaseObject(position, glm::quat())
 {
 }
 
-BaseObject::BaseObject(glm::vec3 position, glm::quat orientaton) : m_position(position), m_scale(1), m_orientation(orientaton), m_isEnabled(true), m_path(nullptr)
+BaseObject::BaseObject(glm::vec3 position, glm::quat orientaton) : m_position(position), m_scale(1), m_orientation(orientaton), m_isEnabled(true), m_path(nullptr), m_collider(nullptr), m_colliderRadius(0)
 {
 }
 
@@ -25,6 +26,7 @@ void BaseObject::Update(GLfloat deltaTime)
 	else
 	{
 		m_position += m_velocity * deltaTime;
+		ResolveCollision();
 	}
 }
 
@@ -53,6 +55,7 @@ void BaseObject::Move(glm::vec3 direction, GLfloat speed)
 	direction = direction * speed;
 	direction = direction * m_orientation;
 	m_position += direction;
+	ResolveCollision();
 }
 
 void BaseObject::SetOrientation(glm::quat orientation)
@@ -115,6 +118,18 @@ bool BaseObject::IsEnabled() const
 	return m_isEnabled;
 }
 
+void BaseObject::SetCollider(const DensityField* field, float radius)
+{
+	m_collider = field;
+	m_colliderRadius = radius;
+}
+
+void BaseObject::ResolveCollision()
+{
+	if (m_collider != nullptr && m_collider->IsReady())
+		m_collider->ResolveSphere(m_position, m_colliderRadius);
+}
+
 void BaseObject::ProcessInput(GLFWwindow& window)
 {
 	if (glfwGetKey(&window, GLFW_KEY_W))
@@ -4,10 +4,12 @@
 #include <glm/gtx/quaternion.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 #include "Global.h"
+#include "RenderQueue.h"
 #include <GLFW/glfw3.h>
 
 class Shader;
 class BasePath;
+class DensityField;
 
 class BaseObject
 {
@@ -17,6 +19,10 @@ public:
 	virtual ~BaseObject();
 	virtual void Update(GLfloat deltaTime);
 	virtual void Render(Shader& shader) const {}
+	// Adds the draw packets of this object to the queue instead of drawing immediately
+	virtual void Submit(RenderQueue&, RenderPass, Shader&) const {}
+	// Per-draw uniforms, set by the RenderQueue right before the packet is drawn
+	virtual void SetDrawUniforms(const Shader&) const {}
 
 	virtual void SetPosition(glm::vec3 position);
 	virtual glm::vec3 GetPosition() const;
@@ -42,6 +48,9 @@ public:
 	
 	virtual void IsEnabled(bool isEnabled);
 	virtual bool IsEnabled() const;
+
+	// Keeps a sphere of the given radius around the object out of the terrain
+	virtual void SetCollider(const DensityField* field, float radius);
 	
 	virtual void ProcessInput(GLFWwindow& window);
 	virtual bool KeyCallback(int key, int scancode, int action, int mode);
@@ -50,6 +59,8 @@ public:
 	virtual glm::mat4 GetMatrix() const;
 
 protected:
+	void ResolveCollision();
+
 	glm::vec3 m_position;
 	glm::vec3 m_velocity;
 	glm::vec3 m_scale;
@@ -58,5 +69,8 @@ protected:
 	bool m_isEnabled;
 
 	BasePath* m_path;
+
+	const DensityField* m_collider;
+	float m_colliderRadius;
 };
 
@@ -27,13 +27,11 @@ void BasePath::Update(GLfloat deltaTime)
 void BasePath::Render(Shader& shader) const
 {
 	glm::vec3 color(1.0f, 0.1f, 0.0f);
-	GLint objectColorLoc = glGetUniformLocation(shader.Program, "objectColor");
-	glUniform3f(objectColorLoc, color.x, color.y, color.z);
+	shader.SetVec3("objectColor", color);
 
 	glm::mat4 modelPos;
 	modelPos = glm::translate(modelPos, glm::vec3(0, 0, 0));
-	GLuint modelLocation = glGetUniformLocation(shader.Program, "model");
-	glUniformMatrix4fv(modelLocation, 1, GL_FALSE, glm::value_ptr(modelPos));
+	shader.SetMat4("model", modelPos);
 
 	glBindVertexArray(m_vao);
 	glDrawArrays(GL_LINE_STRIP, 0, PATH_APPROXIMATION);
@@ -142,20 +142,16 @@ bool BoundingBox::IsHit(Ray& ray) const
 
 void BoundingBox::Render(Shader& shader, int depth) const
 {
-	GLint modelLoc = glGetUniformLocation(shader.Program, "model");
-	glUniformMatrix4fv(modelLoc, 1, GL_FALSE, glm::value_ptr(glm::mat4(1)));
+	shader.SetMat4("model", glm::mat4(1));
 	glCheckError();
 
-	GLint colorModeLoc = glGetUniformLocation(shader.Program, "colorMode");
-	glUniform1i(colorModeLoc, ColorOnly);
+	shader.SetInt("colorMode", ColorOnly);
 	glCheckError();
 
-	GLint objectColorLoc = glGetUniformLocation(shader.Program, "objectColor");
-	glUniform3fv(objectColorLoc, 1, glm::value_ptr(glm::vec3(depth / 5.f, 1 - depth / 5.f, depth / 10.f)));
+	shader.SetVec3("objectColor", glm::vec3(depth / 5.f, 1 - depth / 5.f, depth / 10.f));
 	glCheckError();
 
-	GLint normalModeLoc = glGetUniformLocation(shader.Program, "normalMode");
-	glUniform1i(normalModeLoc, NoNormals);
+	shader.SetInt("normalMode", NoNormals);
 	glCheckError();
 
 	glBindVertexArray(m_vao);
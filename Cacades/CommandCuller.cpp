@@ -0,0 +1,164 @@
+#include "CommandCuller.h"
+#include "RenderQueue.h"
+#include "BaseObject.h"
+#include "HiZBuffer.h"
+#include "Global.h"
+#include "Shader.h"
+#include <cassert>
+
+CommandCuller::CommandCuller() : m_next(0), m_occlusionMode(IgnoreOcclusion), m_hiZ(nullptr)
+{
+	for (int i = 0; i < SEGMENT_COUNT; ++i)
+		m_segmentFences[i] = nullptr;
+
+	m_cullShader = new Shader("./shaders/CullCommands.comp");
+	m_cullShader->Test("CullCommands");
+
+	glGenBuffers(1, &m_buffer);
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_buffer);
+	glBufferData(GL_SHADER_STORAGE_BUFFER, BUFFER_SIZE, nullptr, GL_DYNAMIC_COPY);
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+	glCheckError();
+}
+
+CommandCuller::~CommandCuller()
+{
+	for (int i = 0; i < SEGMENT_COUNT; ++i)
+	{
+		if (m_segmentFences[i])
+			glDeleteSync(m_segmentFences[i]);
+	}
+	glDeleteBuffers(1, &m_buffer);
+	delete m_cullShader;
+}
+
+GLintptr CommandCuller::Cull(const DrawPacket& packet, const Frustum* frustums, GLuint layerMask)
+{
+	GLsizeiptr rangeSize = GetRangeSize(packet.Count);
+	GLsizeiptr size = 0;
+	for (int layer = 0; (layerMask >> layer) != 0; ++layer)
+	{
+		if (layerMask & (1u << layer))
+			size += rangeSize;
+	}
+
+	GLintptr offset = Allocate(size);
+
+	// Commands behind the visible ones stay zero, so they are skipped by draws that can't read the count
+	GLuint zero = 0;
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_buffer);
+	glClearBufferSubData(GL_SHADER_STORAGE_BUFFER, GL_R32UI, offset, size, GL_RED_INTEGER, GL_UNSIGNED_INT, &zero);
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+	glCheckError();
+
+	m_cullShader->Use();
+	m_cullShader->SetMat4("model", packet.Object->GetMatrix());
+	m_cullShader->SetInt("commandCount", packet.Count);
+	m_cullShader->SetInt("sourceFirst", GLint(packet.IndirectOffset / sizeof(GLuint)));
+	m_cullShader->SetInt("boundsFirst", packet.BoundsFirst);
+	glCheckError();
+
+	OcclusionMode occlusionMode = packet.VisibilityBuffer != 0 ? m_occlusionMode : IgnoreOcclusion;
+	m_cullShader->SetInt("occlusionMode", occlusionMode);
+	if (occlusionMode == DrawRevealed)
+	{
+		m_hiZ->Bind();
+		m_cullShader->SetInt("hiZ", HiZBuffer::TEXTURE_UNIT);
+		m_cullShader->SetIVec2("hiZViewport", glm::ivec2(m_hiZ->GetViewportWidth(), m_hiZ->GetViewportHeight()));
+		m_cullShader->SetInt("hiZLevels", m_hiZ->GetLevelCount());
+		m_cullShader->SetMat4("viewProjection", m_viewProjection);
+	}
+	glCheckError();
+
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, packet.IndirectBuffer);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, packet.BoundsBuffer);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, m_buffer);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 3, packet.VisibilityBuffer);
+
+	GLintptr range = offset;
+	for (int layer = 0; (layerMask >> layer) != 0; ++layer)
+	{
+		if (!(layerMask & (1u << layer)))
+			continue;
+
+		const Frustum& frustum = frustums[layer];
+		m_cullShader->SetInt("planeCount", frustum.GetPlaneCount());
+		for (int i = 0; i < frustum.GetPlaneCount(); ++i)
+			m_cullShader->SetVec4(UniformId("planes", i), frustum.GetPlane(i));
+		m_cullShader->SetInt("culledFirst", GLint(range / sizeof(GLuint)));
+		glDispatchCompute((packet.Count + 63) / 64, 1, 1);
+		glCheckError();
+
+		range += rangeSize;
+	}
+
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, 0);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, 0);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, 0);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 3, 0);
+	glCheckError();
+
+	return offset;
+}
+
+GLintptr CommandCuller::Allocate(GLsizeiptr size)
+{
+	assert(size <= SEGMENT_SIZE);
+
+	int segment = int(m_next / SEGMENT_SIZE);
+	if (m_next + size > (segment + 1) * SEGMENT_SIZE)
+	{
+		// Everything reading the segment left has been issued
+		m_segmentFences[segment] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+
+		segment = (segment + 1) % SEGMENT_COUNT;
+		m_next = segment * SEGMENT_SIZE;
+
+		// The fence was set a lap ago and is usually signaled, it only stalls if the GPU is far behind
+		if (m_segmentFences[segment])
+		{
+			glClientWaitSync(m_segmentFences[segment], GL_SYNC_FLUSH_COMMANDS_BIT, GL_TIMEOUT_IGNORED);
+			glDeleteSync(m_segmentFences[segment]);
+			m_segmentFences[segment] = nullptr;
+		}
+		glCheckError();
+	}
+
+	GLintptr offset = m_next;
+	m_next += size;
+	return offset;
+}
+
+void CommandCuller::SetOcclusion(OcclusionMode mode, const HiZBuffer* hiZ, const glm::mat4& viewProjection)
+{
+	m_occlusionMode = mode;
+	m_hiZ = hiZ;
+	m_viewProjection = viewProjection;
+}
+
+void CommandCuller::Barrier() const
+{
+	// Visibility written by DrawRevealed is read by the packets culled after the flush
+	glMemoryBarrier(GL_COMMAND_BARRIER_BIT | GL_SHADER_STORAGE_BARRIER_BIT);
+}
+
+void CommandCuller::Draw(GLenum mode, GLintptr range, GLsizei maxCount) const
+{
+	glBindBuffer(GL_DRAW_INDIRECT_BUFFER, m_buffer);
+	if (GLEW_ARB_indirect_parameters)
+	{
+		glBindBuffer(GL_PARAMETER_BUFFER_ARB, m_buffer);
+		glMultiDrawArraysIndirectCountARB(mode, (const GLvoid*)(range + HEADER_SIZE), range, maxCount, 0);
+		glBindBuffer(GL_PARAMETER_BUFFER_ARB, 0);
+	}
+	else
+		glMultiDrawArraysIndirect(mode, (const GLvoid*)(range + HEADER_SIZE), maxCount, 0);
+	glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+	glCheckError();
+}
+
+GLsizeiptr CommandCuller::GetRangeSize(GLsizei commandCount)
+{
+	// Matches DrawArraysIndirectCommand
+	return HEADER_SIZE + commandCount * 4 * sizeof(GLuint);
+}
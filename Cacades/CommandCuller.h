@@ -0,0 +1,66 @@
+#pragma once
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+class Shader;
+class Frustum;
+class HiZBuffer;
+struct DrawPacket;
+
+// Two phase occlusion culling of packets with a visibility buffer, matches shaders/CullCommands.comp
+enum OcclusionMode
+{
+	// Frustum culling only
+	IgnoreOcclusion,
+	// Commands the last occlusion test found visible
+	DrawVisible,
+	// Tests the commands against the Hi-Z pyramid, stores the result and draws only the ones that
+	// were not visible before, which the DrawVisible phase has missed
+	DrawRevealed
+};
+
+// Culls the indirect draw commands of a packet against frustums on the GPU. The visible commands are
+// compacted into a range of a ring buffer, preceded by their number, so a multi-draw only issues them.
+class CommandCuller
+{
+public:
+	CommandCuller();
+	~CommandCuller();
+
+	// Culls the commands against the frustums selected by layerMask, one range per selected layer.
+	// The packet needs an object and a bounds buffer, returns the offset of the first range.
+	// Leaves the cull program bound, the caller re-binds its own.
+	GLintptr Cull(const DrawPacket& packet, const Frustum* frustums, GLuint layerMask);
+	// Mode of the packets culled afterwards, packets without visibility buffer ignore it.
+	// DrawRevealed tests the bounds transformed by viewProjection against the pyramid of hiZ.
+	void SetOcclusion(OcclusionMode mode, const HiZBuffer* hiZ, const glm::mat4& viewProjection);
+	// Makes the ranges culled so far visible to indirect draws
+	void Barrier() const;
+	// Multi-draw of the visible commands of a range
+	void Draw(GLenum mode, GLintptr range, GLsizei maxCount) const;
+
+	// Bytes of a range of commandCount commands, including its draw count
+	static GLsizeiptr GetRangeSize(GLsizei commandCount);
+
+	// Ranges are reused once the ring wrapped, a few frames later
+	static const GLsizeiptr BUFFER_SIZE = 1 << 18;
+	// The ring is fenced per segment, a range never spans two of them
+	static const int SEGMENT_COUNT = 4;
+	static const GLsizeiptr SEGMENT_SIZE = BUFFER_SIZE / SEGMENT_COUNT;
+	// Draw count of a range, padded to keep the commands aligned
+	static const GLsizeiptr HEADER_SIZE = 16;
+
+protected:
+	// Reserves size bytes of the ring, waits for the draws of the last lap through a segment it enters
+	GLintptr Allocate(GLsizeiptr size);
+
+	Shader* m_cullShader;
+	GLuint m_buffer;
+	GLintptr m_next;
+	// Signaled once the draws of the last lap through a segment are done
+	GLsync m_segmentFences[SEGMENT_COUNT];
+
+	OcclusionMode m_occlusionMode;
+	const HiZBuffer* m_hiZ;
+	glm::mat4 m_viewProjection;
+};
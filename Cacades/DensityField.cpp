@@ -0,0 +1,303 @@
+#include "DensityField.h"
+#include <emmintrin.h>
+#include <algorithm>
+#include <cfloat>
+#include <cstring>
+#include <glm/geometric.hpp>
+#include "Global.h"
+#include "Shader.h"
+
+DensityField::DensityField(GLsizei width, GLsizei depth, GLsizei layers)
+	: m_width(width), m_depth(depth), m_layers(layers), m_texture(0), m_pbo(0), m_fence(nullptr), m_isReady(false), m_isoLevel(0)
+{
+	glGenTextures(1, &m_texture);
+	glBindTexture(GL_TEXTURE_3D, m_texture);
+	glTexStorage3D(GL_TEXTURE_3D, 1, GL_R32F, m_width, m_depth, m_layers);
+	glBindTexture(GL_TEXTURE_3D, 0);
+	glCheckError();
+
+	glGenBuffers(1, &m_pbo);
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, m_pbo);
+	glBufferData(GL_PIXEL_PACK_BUFFER, m_width * m_depth * m_layers * sizeof(float), nullptr, GL_STREAM_READ);
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+	glCheckError();
+
+	SetScale(glm::vec3(1));
+}
+
+DensityField::~DensityField()
+{
+	if (m_fence)
+		glDeleteSync(m_fence);
+	glDeleteBuffers(1, &m_pbo);
+	glDeleteTextures(1, &m_texture);
+}
+
+void DensityField::Bake(Shader& bakeShader)
+{
+	bakeShader.Use();
+	glBindImageTexture(0, m_texture, 0, GL_TRUE, 0, GL_WRITE_ONLY, GL_R32F);
+	glDispatchCompute((m_width + 7) / 8, (m_depth + 7) / 8, (m_layers + 3) / 4);
+	glMemoryBarrier(GL_PIXEL_BUFFER_BARRIER_BIT | GL_TEXTURE_UPDATE_BARRIER_BIT);
+	glBindImageTexture(0, 0, 0, GL_TRUE, 0, GL_WRITE_ONLY, GL_R32F);
+	glCheckError();
+
+	// Copy into the PBO, this returns immediately and the data is picked up in Poll()
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, m_pbo);
+	glBindTexture(GL_TEXTURE_3D, m_texture);
+	glGetTexImage(GL_TEXTURE_3D, 0, GL_RED, GL_FLOAT, nullptr);
+	glBindTexture(GL_TEXTURE_3D, 0);
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+	glCheckError();
+
+	if (m_fence)
+		glDeleteSync(m_fence);
+	m_fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	glCheckError();
+}
+
+bool DensityField::Poll()
+{
+	if (!m_fence)
+		return false;
+
+	GLenum state = glClientWaitSync(m_fence, 0, 0);
+	if (state != GL_ALREADY_SIGNALED && state != GL_CONDITION_SATISFIED)
+		return false;
+
+	glDeleteSync(m_fence);
+	m_fence = nullptr;
+
+	size_t size = m_width * m_depth * m_layers;
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, m_pbo);
+	const float* data = static_cast<const float*>(glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, size * sizeof(float), GL_MAP_READ_BIT));
+	if (data)
+	{
+		m_data.resize(size);
+		memcpy(m_data.data(), data, size * sizeof(float));
+		glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+		m_isReady = true;
+	}
+	else
+		printf("ERROR::DENSITY_FIELD::MAP_BUFFER_FAILED\n");
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+	glCheckError();
+
+	return data != nullptr;
+}
+
+bool DensityField::IsReady() const
+{
+	return m_isReady;
+}
+
+void DensityField::SetScale(glm::vec3 scale)
+{
+	m_scale = scale;
+
+	// world -> generator space [-1, 1] -> texel space, where texel centers lie on integers
+	glm::vec3 size = glm::vec3(m_width, m_layers, m_depth);
+	m_texelScale = 0.5f * size / scale;
+	m_texelOffset = 0.5f * size - 0.5f;
+	m_gradientStep = 2.0f * scale / size;
+}
+
+void DensityField::SetIsoLevel(float isoLevel)
+{
+	m_isoLevel = isoLevel;
+}
+
+float DensityField::GetIsoLevel() const
+{
+	return m_isoLevel;
+}
+
+float DensityField::Sample(glm::vec3 position) const
+{
+	float value;
+	Sample(&position, &value, 1);
+	return value;
+}
+
+glm::vec3 DensityField::Gradient(glm::vec3 position) const
+{
+	glm::vec3 gradient;
+	Gradient(&position, &gradient, 1);
+	return gradient;
+}
+
+void DensityField::Sample(const glm::vec3* positions, float* values, size_t count) const
+{
+	if (!m_isReady)
+	{
+		std::fill(values, values + count, -FLT_MAX);
+		return;
+	}
+
+	for (size_t i = 0; i < count; i += 4)
+	{
+		size_t lanes = std::min<size_t>(4, count - i);
+		__m128 x, y, z;
+		LoadSoa(positions + i, lanes, x, y, z);
+
+		alignas(16) float result[4];
+		_mm_store_ps(result, SampleSoa(x, y, z));
+		std::copy(result, result + lanes, values + i);
+	}
+}
+
+void DensityField::Gradient(const glm::vec3* positions, glm::vec3* gradients, size_t count) const
+{
+	if (!m_isReady)
+	{
+		std::fill(gradients, gradients + count, glm::vec3(0));
+		return;
+	}
+
+	for (size_t i = 0; i < count; i += 4)
+	{
+		size_t lanes = std::min<size_t>(4, count - i);
+		__m128 x, y, z, gx, gy, gz;
+		LoadSoa(positions + i, lanes, x, y, z);
+		GradientSoa(x, y, z, gx, gy, gz);
+
+		alignas(16) float rx[4], ry[4], rz[4];
+		_mm_store_ps(rx, gx);
+		_mm_store_ps(ry, gy);
+		_mm_store_ps(rz, gz);
+		for (size_t lane = 0; lane < lanes; ++lane)
+			gradients[i + lane] = glm::vec3(rx[lane], ry[lane], rz[lane]);
+	}
+}
+
+bool DensityField::ResolveSphere(glm::vec3& center, float radius) const
+{
+	bool collided;
+	ResolveSpheres(&center, &radius, &collided, 1);
+	return collided;
+}
+
+void DensityField::ResolveSpheres(glm::vec3* centers, const float* radii, bool* collided, size_t count) const
+{
+	std::fill(collided, collided + count, false);
+	if (!m_isReady)
+		return;
+
+	const int ITERATIONS = 3;
+	const size_t CHUNK = 64;
+	float values[CHUNK];
+	glm::vec3 gradients[CHUNK];
+
+	for (size_t offset = 0; offset < count; offset += CHUNK)
+	{
+		size_t chunk = std::min(CHUNK, count - offset);
+		for (int iteration = 0; iteration < ITERATIONS; ++iteration)
+		{
+			Sample(centers + offset, values, chunk);
+			Gradient(centers + offset, gradients, chunk);
+
+			for (size_t i = 0; i < chunk; ++i)
+			{
+				float slope = glm::length(gradients[i]);
+				if (slope < 0.00001f)
+					continue;
+
+				// First order distance to the iso surface, positive inside the rock
+				float depth = (values[i] - m_isoLevel) / slope;
+				float penetration = radii[offset + i] + depth;
+				if (penetration <= 0)
+					continue;
+
+				// The field grows towards the rock, so the surface normal is the negative gradient
+				centers[offset + i] -= gradients[i] / slope * penetration;
+				collided[offset + i] = true;
+			}
+		}
+	}
+}
+
+__m128 DensityField::SampleSoa(__m128 x, __m128 y, __m128 z) const
+{
+	// Transform to texel space and clamp, so that the upper neighbour is always inside the texture
+	__m128 tx = _mm_add_ps(_mm_mul_ps(x, _mm_set1_ps(m_texelScale.x)), _mm_set1_ps(m_texelOffset.x));
+	__m128 ty = _mm_add_ps(_mm_mul_ps(y, _mm_set1_ps(m_texelScale.y)), _mm_set1_ps(m_texelOffset.y));
+	__m128 tz = _mm_add_ps(_mm_mul_ps(z, _mm_set1_ps(m_texelScale.z)), _mm_set1_ps(m_texelOffset.z));
+	tx = _mm_min_ps(_mm_max_ps(tx, _mm_setzero_ps()), _mm_set1_ps(m_width - 1.001f));
+	ty = _mm_min_ps(_mm_max_ps(ty, _mm_setzero_ps()), _mm_set1_ps(m_layers - 1.001f));
+	tz = _mm_min_ps(_mm_max_ps(tz, _mm_setzero_ps()), _mm_set1_ps(m_depth - 1.001f));
+
+	// Coordinates are positive, so truncation equals floor
+	__m128i ix = _mm_cvttps_epi32(tx);
+	__m128i iy = _mm_cvttps_epi32(ty);
+	__m128i iz = _mm_cvttps_epi32(tz);
+	__m128 fx = _mm_sub_ps(tx, _mm_cvtepi32_ps(ix));
+	__m128 fy = _mm_sub_ps(ty, _mm_cvtepi32_ps(iy));
+	__m128 fz = _mm_sub_ps(tz, _mm_cvtepi32_ps(iz));
+
+	// Texture layout is width x depth x layers
+	alignas(16) int index[4];
+	alignas(16) int lx[4], ly[4], lz[4];
+	_mm_store_si128(reinterpret_cast<__m128i*>(lx), ix);
+	_mm_store_si128(reinterpret_cast<__m128i*>(ly), iy);
+	_mm_store_si128(reinterpret_cast<__m128i*>(lz), iz);
+	for (int lane = 0; lane < 4; ++lane)
+		index[lane] = (ly[lane] * m_depth + lz[lane]) * m_width + lx[lane];
+
+	// Gather the 8 corners, SSE has no gather instruction
+	const int strideZ = m_width;
+	const int strideY = m_width * m_depth;
+	alignas(16) float c[8][4];
+	for (int lane = 0; lane < 4; ++lane)
+	{
+		const float* base = m_data.data() + index[lane];
+		c[0][lane] = base[0];
+		c[1][lane] = base[1];
+		c[2][lane] = base[strideZ];
+		c[3][lane] = base[strideZ + 1];
+		c[4][lane] = base[strideY];
+		c[5][lane] = base[strideY + 1];
+		c[6][lane] = base[strideY + strideZ];
+		c[7][lane] = base[strideY + strideZ + 1];
+	}
+
+	__m128 corner[8];
+	for (int i = 0; i < 8; ++i)
+		corner[i] = _mm_load_ps(c[i]);
+
+	// Trilinear interpolation, x first, then z, then y
+	__m128 x00 = _mm_add_ps(corner[0], _mm_mul_ps(fx, _mm_sub_ps(corner[1], corner[0])));
+	__m128 x01 = _mm_add_ps(corner[2], _mm_mul_ps(fx, _mm_sub_ps(corner[3], corner[2])));
+	__m128 x10 = _mm_add_ps(corner[4], _mm_mul_ps(fx, _mm_sub_ps(corner[5], corner[4])));
+	__m128 x11 = _mm_add_ps(corner[6], _mm_mul_ps(fx, _mm_sub_ps(corner[7], corner[6])));
+	__m128 z0 = _mm_add_ps(x00, _mm_mul_ps(fz, _mm_sub_ps(x01, x00)));
+	__m128 z1 = _mm_add_ps(x10, _mm_mul_ps(fz, _mm_sub_ps(x11, x10)));
+	return _mm_add_ps(z0, _mm_mul_ps(fy, _mm_sub_ps(z1, z0)));
+}
+
+void DensityField::GradientSoa(__m128 x, __m128 y, __m128 z, __m128& gx, __m128& gy, __m128& gz) const
+{
+	// Central differences with a step of one texel
+	__m128 hx = _mm_set1_ps(m_gradientStep.x);
+	__m128 hy = _mm_set1_ps(m_gradientStep.y);
+	__m128 hz = _mm_set1_ps(m_gradientStep.z);
+
+	gx = _mm_div_ps(_mm_sub_ps(SampleSoa(_mm_add_ps(x, hx), y, z), SampleSoa(_mm_sub_ps(x, hx), y, z)), _mm_add_ps(hx, hx));
+	gy = _mm_div_ps(_mm_sub_ps(SampleSoa(x, _mm_add_ps(y, hy), z), SampleSoa(x, _mm_sub_ps(y, hy), z)), _mm_add_ps(hy, hy));
+	gz = _mm_div_ps(_mm_sub_ps(SampleSoa(x, y, _mm_add_ps(z, hz)), SampleSoa(x, y, _mm_sub_ps(z, hz))), _mm_add_ps(hz, hz));
+}
+
+void DensityField::LoadSoa(const glm::vec3* positions, size_t count, __m128& x, __m128& y, __m128& z)
+{
+	// Missing lanes repeat the last position
+	alignas(16) float px[4], py[4], pz[4];
+	for (size_t lane = 0; lane < 4; ++lane)
+	{
+		const glm::vec3& p = positions[std::min(lane, count - 1)];
+		px[lane] = p.x;
+		py[lane] = p.y;
+		pz[lane] = p.z;
+	}
+	x = _mm_load_ps(px);
+	y = _mm_load_ps(py);
+	z = _mm_load_ps(pz);
+}
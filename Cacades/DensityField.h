@@ -0,0 +1,53 @@
+#pragma once
+#include <GL/glew.h>
+#include <glm/detail/type_vec3.hpp>
+#include <vector>
+#include <xmmintrin.h>
+
+class Shader;
+
+// CPU copy of the final scalar field (density plus noise) of the generator.
+// Solid rock is where the field is above the iso level, positions are given in world space.
+class DensityField
+{
+public:
+	DensityField(GLsizei width, GLsizei depth, GLsizei layers);
+	~DensityField();
+
+	// Evaluates the field with bakeShader, whose uniforms have to be set, and starts an asynchronous read back
+	void Bake(Shader& bakeShader);
+	// Finishes the read back once the GPU is done, returns true when new data arrived
+	bool Poll();
+	bool IsReady() const;
+
+	void SetScale(glm::vec3 scale);
+	void SetIsoLevel(float isoLevel);
+	float GetIsoLevel() const;
+
+	float Sample(glm::vec3 position) const;
+	glm::vec3 Gradient(glm::vec3 position) const;
+	void Sample(const glm::vec3* positions, float* values, size_t count) const;
+	void Gradient(const glm::vec3* positions, glm::vec3* gradients, size_t count) const;
+
+	// Pushes the sphere out of the rock, returns true if it intersected the terrain
+	bool ResolveSphere(glm::vec3& center, float radius) const;
+	void ResolveSpheres(glm::vec3* centers, const float* radii, bool* collided, size_t count) const;
+
+protected:
+	__m128 SampleSoa(__m128 x, __m128 y, __m128 z) const;
+	void GradientSoa(__m128 x, __m128 y, __m128 z, __m128& gx, __m128& gy, __m128& gz) const;
+	static void LoadSoa(const glm::vec3* positions, size_t count, __m128& x, __m128& y, __m128& z);
+
+	GLsizei m_width, m_depth, m_layers;
+	GLuint m_texture;
+	GLuint m_pbo;
+	GLsync m_fence;
+
+	std::vector<float> m_data;
+	bool m_isReady;
+
+	glm::vec3 m_scale;
+	glm::vec3 m_texelScale, m_texelOffset;
+	glm::vec3 m_gradientStep;
+	float m_isoLevel;
+};
@@ -2,55 +2,23 @@
 #include "Shader.h"
 #include <glm/gtc/type_ptr.hpp>
 #include "Box.h"
+#include "RenderInfo.h"
 
 
-DirectionalLight::DirectionalLight(glm::vec3 position, glm::vec3 color, Shader& shadowShader, GLfloat farPlane, GLfloat nearPlane) : DirectionalLight(position, glm::quat(), color, shadowShader, farPlane, nearPlane)
+DirectionalLight::DirectionalLight(glm::vec3 position, glm::vec3 color, Shader& shadowShader, GLfloat farPlane, GLfloat nearPlane)
+	: DirectionalLight(position, glm::quat(), color, shadowShader, MAX_CASCADES, farPlane, nearPlane)
 {
 }
 
-DirectionalLight::DirectionalLight(glm::vec3 position, glm::quat orientation, glm::vec3 color, Shader& shadowShader, GLfloat farPlane, GLfloat nearPlane) : Light(position, orientation, color, shadowShader, nearPlane, farPlane)
+DirectionalLight::DirectionalLight(glm::vec3 position, glm::quat orientation, glm::vec3 color, Shader& shadowShader, GLuint maxCascades, GLfloat farPlane, GLfloat nearPlane)
+	: Light(position, orientation, color, shadowShader, nearPlane, farPlane), m_maxCascades(maxCascades), m_cascadeCount(1)
 {
-	glGenFramebuffers(1, &shadowMapFBO);
-	glBindFramebuffer(GL_FRAMEBUFFER, shadowMapFBO);
-
-	textureType = GL_TEXTURE_2D;
-
-	glGenTextures(1, &shadowMap);
-	glBindTexture(textureType, shadowMap);
-
-	glTexImage2D(textureType, 0, GL_RG32F, SHADOW_WIDTH, SHADOW_HEIGHT, 0, GL_RG, GL_FLOAT, nullptr);
-	glTexParameteri(textureType, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-	glTexParameteri(textureType, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-	glTexParameteri(textureType, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_BORDER);
-	glTexParameteri(textureType, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_BORDER);
-	GLfloat borderColor[] = { 1.0, 1.0, 1.0, 1.0 };
-	glTexParameterfv(textureType, GL_TEXTURE_BORDER_COLOR, borderColor);
-	glCheckError();
-
-	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, textureType, shadowMap, 0);
-	glBindTexture(textureType, 0);
-	glCheckError();
-	
-	glGenTextures(1, &depthAttachment);
-	glBindTexture(textureType, depthAttachment);
-
-	glTexImage2D(textureType, 0, GL_DEPTH_COMPONENT, SHADOW_WIDTH, SHADOW_HEIGHT, 0, GL_DEPTH_COMPONENT, GL_FLOAT, nullptr);
-	glTexParameteri(textureType, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-	glTexParameteri(textureType, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-	glTexParameteri(textureType, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_BORDER);
-	glTexParameteri(textureType, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_BORDER);
-
-	glTexParameterfv(textureType, GL_TEXTURE_BORDER_COLOR, borderColor);
-	glCheckError();
-
-	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, depthAttachment, 0);
-	glBindTexture(textureType, 0);
-	glCheckError();
-
-	glCheckFrameBuffer();
-
-	glBindFramebuffer(GL_FRAMEBUFFER, 0);
-	glCheckError();
+	for (int i = 0; i < MAX_CASCADES; ++i)
+	{
+		m_cascadeSplits[i] = m_renderedSplits[i] = 0.0f;
+		m_cascadeCenters[i] = m_renderedCenters[i] = glm::vec3(0);
+		m_cascadePadding[i] = 0.0f;
+	}
 
 	m_debugCube = new Model(m_position, glm::quat(), Box::GetTris(glm::vec3(.1f, .1f, 1)), 12, m_color, NoNormals);
 }
@@ -59,33 +27,159 @@ DirectionalLight::~DirectionalLight()
 {
 }
 
-void DirectionalLight::UpdateUniforms(const Shader& shader, int lightIndex, int textureIndex)
+void DirectionalLight::WriteLightData(LightData& data)
+{
+	Light::WriteLightData(data);
+
+	// Without a shadow map the cone of spot lights still needs the current matrix
+	const glm::mat4* matrices = data.CastShadow ? m_renderedMatrices : m_cascadeMatrices;
+	const GLfloat* splits = data.CastShadow ? m_renderedSplits : m_cascadeSplits;
+	for (GLuint i = 0; i < m_cascadeCount; ++i)
+	{
+		data.LightSpaceMatrices[i] = matrices[i];
+		data.CascadeSplits[i] = splits[i];
+	}
+	data.CascadeCount = m_cascadeCount;
+}
+
+void DirectionalLight::PreRender(GLuint faceMask, const ShadowAtlas& atlas) const
 {
-	Light::UpdateUniforms(shader, lightIndex, textureIndex);
+	for (GLuint cascade = 0; cascade < m_cascadeCount && cascade < m_shadowTiles.size(); ++cascade)
+	{
+		if (faceMask & (1u << cascade))
+			atlas.ClearTile(m_shadowTiles[cascade]);
+	}
+
+	m_shadowShader.Use();
+}
 
-	GLint lightSpaceMatrixLoc = glGetUniformLocation(shader.Program, ("Lights[" + std::to_string(lightIndex) + "].lightSpaceMatrix").c_str());
-	glUniformMatrix4fv(lightSpaceMatrixLoc, 1, GL_FALSE, glm::value_ptr(GetShadowMatrix()));
-	glCheckError();
+GLuint DirectionalLight::GetShadowFaceCount() const
+{
+	return m_cascadeCount;
+}
 
-	glActiveTexture(GL_TEXTURE0 + textureIndex);
-	glBindTexture(textureType, shadowMap);
-	GLuint depthMapPos = glGetUniformLocation(shader.Program, ("Lights[" + std::to_string(lightIndex) + "].depthMap").c_str());
-	glUniform1i(depthMapPos, textureIndex);
-	glCheckError();
+void DirectionalLight::FitToView(const glm::mat4& view, const glm::mat4& projection, const RenderInfo& renderInfo)
+{
+	if (m_maxCascades == 1)
+	{
+		m_cascadeCount = 1;
+		m_cascadeMatrices[0] = GetShadowMatrix();
+		m_cascadeSplits[0] = m_farPlane;
+		return;
+	}
+
+	m_cascadeCount = glm::clamp(renderInfo.ShadowCascades, 1, int(m_maxCascades));
+
+	// Depth range of the camera, read back from its perspective projection
+	GLfloat cameraNear = projection[3][2] / (projection[2][2] - 1.0f);
+	GLfloat cameraFar = projection[3][2] / (projection[2][2] + 1.0f);
+	GLfloat shadowFar = glm::min(cameraFar, renderInfo.ShadowDistance);
+
+	glm::mat4 inverseViewProjection = glm::inverse(projection * view);
+	glm::mat4 lightView = GetCascadeView();
+
+	GLfloat splitNear = cameraNear;
+	for (GLuint cascade = 0; cascade < m_cascadeCount; ++cascade)
+	{
+		// Blend of logarithmic and uniform splits
+		GLfloat t = (cascade + 1.0f) / m_cascadeCount;
+		GLfloat logSplit = cameraNear * glm::pow(shadowFar / cameraNear, t);
+		GLfloat uniformSplit = cameraNear + (shadowFar - cameraNear) * t;
+		GLfloat splitFar = glm::mix(uniformSplit, logSplit, renderInfo.CascadeSplitLambda);
+
+		glm::vec3 corners[8];
+		glm::vec3 center(0);
+		for (int i = 0; i < 8; ++i)
+		{
+			glm::vec4 clip = projection * glm::vec4(0, 0, -(i & 4 ? splitFar : splitNear), 1);
+			glm::vec4 corner = inverseViewProjection * glm::vec4(i & 1 ? 1 : -1, i & 2 ? 1 : -1, clip.z / clip.w, 1);
+			corners[i] = glm::vec3(corner) / corner.w;
+			center += corners[i] / 8.0f;
+		}
+
+		// A bounding sphere keeps the size of the cascade constant while the camera rotates
+		GLfloat radius = 0;
+		for (int i = 0; i < 8; ++i)
+			radius = glm::max(radius, glm::length(corners[i] - center));
+		radius += m_cascadePadding[cascade];
+		radius = glm::ceil(radius * 16.0f) / 16.0f;
+		m_cascadeCenters[cascade] = center;
+
+		// Moving the cascade in whole texels keeps the shadow edges from shimmering.
+		// The tile of the last allocation is used, a resized tile is rendered again anyway.
+		glm::vec3 lightCenter(lightView * glm::vec4(center, 1.0f));
+		if (cascade < m_shadowTiles.size())
+		{
+			GLfloat texelSize = 2.0f * radius / m_shadowTiles[cascade].Size;
+			lightCenter.x = glm::floor(lightCenter.x / texelSize) * texelSize;
+			lightCenter.y = glm::floor(lightCenter.y / texelSize) * texelSize;
+		}
+
+		// Casters between the light and the cascade are kept by pulling the near plane back by the far plane of the light
+		glm::mat4 cascadeProjection = glm::ortho(lightCenter.x - radius, lightCenter.x + radius, lightCenter.y - radius, lightCenter.y + radius,
+			-lightCenter.z - radius - m_farPlane, -lightCenter.z + radius);
+
+		m_cascadeMatrices[cascade] = cascadeProjection * lightView;
+		m_cascadeSplits[cascade] = splitFar;
+		splitNear = splitFar;
+	}
 }
 
-void DirectionalLight::PreRender() const
+GLuint DirectionalLight::GetStaleFaces() const
 {
-	glViewport(0, 0, SHADOW_WIDTH, SHADOW_HEIGHT);
-	glBindFramebuffer(GL_FRAMEBUFFER, shadowMapFBO);
-	glClearColor(1.0f, 1.0f, 1.0f, 1.0f);
-	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+	GLuint faces = 0;
+	for (GLuint i = 0; i < m_cascadeCount; ++i)
+	{
+		if (m_cascadeMatrices[i] != m_renderedMatrices[i] || m_cascadeSplits[i] != m_renderedSplits[i])
+			faces |= 1u << i;
+	}
+	return faces;
+}
 
-	m_shadowShader.Use();
+void DirectionalLight::RenderShadowMap(GLuint faceMask, const ShadowAtlas& atlas, RenderQueue& queue, const std::vector<const BaseObject*>& casters) const
+{
+	PreRender(faceMask, atlas);
+
+	Frustum frustums[MAX_CASCADES];
+	for (GLuint i = 0; i < m_cascadeCount; ++i)
+		frustums[i] = Frustum(m_cascadeMatrices[i]);
+
+	for (GLuint cascade = 0; cascade < m_cascadeCount && cascade < m_shadowTiles.size(); ++cascade)
+	{
+		if (!(faceMask & (1u << cascade)))
+			continue;
+
+		m_shadowTiles[cascade].SetViewport();
+		m_shadowShader.SetMat4("lightSpaceMatrix", m_cascadeMatrices[cascade]);
+		glCheckError();
+
+		queue.SetLayerFrustums(frustums, 1u << cascade, false);
+		for (std::vector<const BaseObject*>::const_iterator it = casters.begin(); it != casters.end(); ++it)
+			(*it)->Submit(queue, ShadowPass, m_shadowShader);
+		queue.Flush();
+
+		// Movement over the last refresh interval, expected again until the next one. Bounded by the
+		// size of the slice so a jump of the camera doesn't blow the cascade up.
+		if (m_renderedSplits[cascade] > 0.0f)
+		{
+			GLfloat sliceLength = m_cascadeSplits[cascade] - (cascade > 0 ? m_cascadeSplits[cascade - 1] : 0.0f);
+			m_cascadePadding[cascade] = glm::min(glm::length(m_cascadeCenters[cascade] - m_renderedCenters[cascade]), sliceLength);
+		}
+
+		m_renderedMatrices[cascade] = m_cascadeMatrices[cascade];
+		m_renderedSplits[cascade] = m_cascadeSplits[cascade];
+		m_renderedCenters[cascade] = m_cascadeCenters[cascade];
+	}
+
+	queue.ClearLayerFrustums();
+	glDisable(GL_CULL_FACE);
+}
 
-	GLint lightSpaceMatrixLoc = glGetUniformLocation(m_shadowShader.Program, "lightSpaceMatrix");
-	glUniformMatrix4fv(lightSpaceMatrixLoc, 1, GL_FALSE, glm::value_ptr(GetShadowMatrix()));
-	glCheckError();
+GLfloat DirectionalLight::GetShadowImportance(const glm::mat4& view, const glm::mat4& projection) const
+{
+	if (m_maxCascades == 1)
+		return Light::GetShadowImportance(view, projection);
+	return 1.0f;
 }
 
 void DirectionalLight::RenderDebug(Shader& shader) const
@@ -114,3 +208,10 @@ glm::mat4 DirectionalLight::GetShadowMatrix() const
 {
 	return GetProjection() * GetView();
 }
+
+glm::mat4 DirectionalLight::GetCascadeView() const
+{
+	glm::vec3 direction = -glm::normalize(m_position);
+	glm::vec3 up = glm::abs(direction.y) > 0.99f ? glm::vec3(0.0f, 0.0f, 1.0f) : glm::vec3(0.0f, 1.0f, 0.0f);
+	return glm::lookAt(glm::vec3(0), direction, up);
+}
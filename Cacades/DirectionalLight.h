@@ -1,21 +1,49 @@
 #pragma once
 #include "Light.h"
+#include "FrameUniforms.h"
+
+// Directional lights split the camera frustum into cascades, each rendered into its own tile of the
+// shadow atlas. Spot lights derive from it with a single cascade and a fixed projection.
 class DirectionalLight : public Light
 {
 public:
 	DirectionalLight(glm::vec3 position, glm::vec3 color, Shader& shadowShader, GLfloat farPlane, GLfloat nearPlane = 0.1f);
 	virtual ~DirectionalLight();
 
-	void UpdateUniforms(const Shader& shader, int lightIndex, int textureIndex) override;
+	void WriteLightData(LightData& data) override;
 
-	void PreRender() const override;
+	void PreRender(GLuint faceMask, const ShadowAtlas& atlas) const override;
+	// Faces are the cascades
+	GLuint GetShadowFaceCount() const override;
+	void FitToView(const glm::mat4& view, const glm::mat4& projection, const RenderInfo& renderInfo) override;
+	GLuint GetStaleFaces() const override;
+	void RenderShadowMap(GLuint faceMask, const ShadowAtlas& atlas, RenderQueue& queue, const std::vector<const BaseObject*>& casters) const override;
+	// Cascades cover the whole view
+	GLfloat GetShadowImportance(const glm::mat4& view, const glm::mat4& projection) const override;
 	void RenderDebug(Shader& shader) const override;
 
+	static const int MAX_CASCADES = LightData::MAX_CASCADES;
+
 protected:
-	DirectionalLight(glm::vec3 position, glm::quat orientation, glm::vec3 color, Shader& shadowShader, GLfloat farPlane, GLfloat nearPlane = 0.1f);
+	DirectionalLight(glm::vec3 position, glm::quat orientation, glm::vec3 color, Shader& shadowShader, GLuint maxCascades, GLfloat farPlane, GLfloat nearPlane = 0.1f);
 	LightType GetType() override;
 	virtual glm::mat4 GetProjection() const;
 	virtual glm::mat4 GetView() const;
 	glm::mat4 GetShadowMatrix() const;
-};
+	// Rotation of the light, shared by all cascades
+	glm::mat4 GetCascadeView() const;
 
+	GLuint m_maxCascades;
+	GLuint m_cascadeCount;
+	glm::mat4 m_cascadeMatrices[MAX_CASCADES];
+	GLfloat m_cascadeSplits[MAX_CASCADES];
+	// Matrices and splits the tiles were rendered with, the lighting has to use these
+	mutable glm::mat4 m_renderedMatrices[MAX_CASCADES];
+	mutable GLfloat m_renderedSplits[MAX_CASCADES];
+	// Cascades are refreshed on different frames, so each one is padded by how far the center of its
+	// view slice moved between its last two renders. That keeps a slice of the current view covered by
+	// its stale tile up to the split planes while the camera moves or turns.
+	glm::vec3 m_cascadeCenters[MAX_CASCADES];
+	mutable glm::vec3 m_renderedCenters[MAX_CASCADES];
+	mutable GLfloat m_cascadePadding[MAX_CASCADES];
+};
@@ -9,16 +9,22 @@
 #include "Font.h"
 #include "Hud.h"
 #include "Light.h"
+#include "PointLight.h"
+#include "LightSwarm.h"
 #include "Plane.h"
+#include "MeshExporter.h"
 
 Engine::Engine(GLFWwindow& window)
-	: m_window(window), m_camera(), m_generator(),
+	: m_window(window), m_camera(), m_frameTimer(0.25f), m_lightSwarm(nullptr), m_shadowGeneration(0), m_generator(),
 	m_particleSystem(m_camera, m_generator.GetDensityTexture(), m_generator.GetNormalTexture()),
 	m_activeObject(-1), m_mesh(nullptr), m_greenOrb(new Icosahedron(glm::vec3(0), MakeQuat(0, 0, 0), glm::vec3(0, 0.5f, 0.1f))), m_redOrb(new Icosahedron(glm::vec3(0), MakeQuat(0, 0, 0), glm::vec3(0, 0.5f, 0.1f)))
 {
 	m_geometryShader = new Shader("./shaders/TriPlanar.vert", "./shaders/TriPlanar.tesc", "./shaders/TriPlanar.tese", "./shaders/TriPlanar.geom", "./shaders/TriPlanar.frag");
 	m_geometryShader->Test("TriPlanar");
 
+	m_geometryFlatShader = new Shader("./shaders/TriPlanarFlat.vert", nullptr, "./shaders/TriPlanar.frag");
+	m_geometryFlatShader->Test("TriPlanarFlat");
+
 	m_oreShader = new Shader("./shaders/Tessellation.vert", "./shaders/Tessellation.tesc", "./shaders/Tessellation.tese", "./shaders/Tessellation.geom", "./shaders/Tessellation.frag");
 	m_oreShader->Test("Tesselation");
 
@@ -28,11 +34,34 @@ Engine::Engine(GLFWwindow& window)
 	m_debugShader = new Shader("./shaders/Simple.vert", nullptr, "./shaders/Simple.frag");
 	m_debugShader->Test("Debug");
 
+	m_decorationShader = new Shader("./shaders/Decoration.vert", nullptr, "./shaders/Decoration.frag");
+	m_decorationShader->Test("Decoration");
+
+	m_depthShader = new Shader("./shaders/DepthOnly.vert", nullptr, nullptr);
+	m_depthShader->Test("DepthOnly");
+
+	m_depthPatchShader = new Shader("./shaders/DepthOnlyPatch.vert", "./shaders/DepthOnly.tesc", "./shaders/DepthOnly.tese", nullptr, nullptr);
+	m_depthPatchShader->Test("DepthOnlyPatch");
+
 	Shader* hudShader = new Shader("./shaders/Text.vert", nullptr, "./shaders/Text.frag");
 	hudShader->Test("Text/Hud");
 	Font* font = new Font("fonts/arial.ttf", glm::ivec2(0, 24));
 	m_hud = new Hud(*font, *hudShader);
 
+	m_shadowAtlas = new ShadowAtlas(m_renderInfo.ShadowAtlasSize);
+	m_shadowAtlas->SetShadowMode(m_renderInfo.ShadowMode);
+	m_lightClusters = new LightClusters();
+	m_gBuffer = new GBuffer();
+	m_commandCuller = new CommandCuller();
+	m_hiZBuffer = new HiZBuffer();
+	m_renderQueue.SetCommandCuller(m_renderInfo.GpuCulling ? m_commandCuller : nullptr);
+
+	m_renderInfo.AntiAliasing.Init();
+	m_renderTarget = new RenderTarget();
+	m_renderTarget->Resize(SCREEN_WIDTH, SCREEN_HEIGHT, m_renderInfo.AntiAliasing.ActiveSamples);
+	m_resolutionGovernor.SetTarget(m_renderInfo.TargetFrameTime);
+	m_resolutionGovernor.SetScaleRange(m_renderInfo.MinRenderScale, m_renderInfo.MaxRenderScale);
+
 	Texture* floorTex = new Texture("textures/brick_d.png");
 	Texture* floorNormal = new Texture("textures/brick_n.png");
 	Texture* floorHeight = new Texture("textures/brick_h.png");
@@ -55,8 +84,8 @@ GLFWwindow* Engine::InitWindow(const char* windowTitle, bool fullscreen)
 	glfwInit();
 	// Set all the required options for GLFW
 
-	glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
-	glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+	glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
+	glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 4);
 	glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
 	glfwWindowHint(GLFW_RESIZABLE, GL_TRUE);
 	glfwWindowHint(GLFW_OPENGL_DEBUG_CONTEXT, GL_TRUE);
@@ -146,16 +175,31 @@ void Engine::Start()
 	m_generator.Generate3dTexture();
 	m_mesh = m_generator.GenerateMesh();
 
+	m_camera.SetCollider(&m_generator.GetDensityField(), 0.25f);
+
 	Loop();
 }
 
 void Engine::AddLight(Light& light)
 {
 	m_lights.push_back(&light);
+	light.SetCollider(&m_generator.GetDensityField(), 0.1f);
+}
+
+void Engine::AddLightSwarm(LightSwarm& swarm)
+{
+	m_lightSwarm = &swarm;
+	m_lights.insert(m_lights.end(), swarm.GetLights().begin(), swarm.GetLights().end());
+
+	glm::vec3 scale = m_generator.GetGeometryScale();
+	swarm.Spawn(-scale, scale);
 }
 
 void Engine::Update(GLfloat deltaTime)
 {
+	m_generator.GetDensityField().Poll();
+	m_generator.PollMeshOverflow();
+
 	MoveActiveObject();
 
 	m_hud->Update(m_updateInfo.FPS, m_renderInfo);
@@ -170,6 +214,8 @@ void Engine::Update(GLfloat deltaTime)
 		if ((*it)->IsEnabled())
 			(*it)->Update(deltaTime);
 	}
+	if (m_lightSwarm)
+		m_lightSwarm->Update(deltaTime);
 	m_greenOrb->SetColor(m_lights[0]->GetColor());
 	m_greenOrb->SetPosition(m_lights[0]->GetPosition());
 	m_greenOrb->SetOrientation(m_lights[0]->GetOrientation());
@@ -184,27 +230,91 @@ void Engine::Update(GLfloat deltaTime)
 
 void Engine::RenderScene()
 {
+	UpdateFrameUniforms();
+
 	if (m_renderInfo.WireFrameMode)
 		glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
 
-	m_geometryShader->Use();
-	UpdateUniforms(*m_geometryShader);
-	m_mesh->Render(*m_geometryShader, true);
+	Shader* sceneShaders[] = { m_geometryShader, m_geometryFlatShader, m_oreShader, m_floorShader };
+	for (Shader* shader : sceneShaders)
+	{
+		shader->Use();
+		m_frameUniforms.BindShadowSamplers(*shader);
+		shader->SetBool("WriteGBuffer", m_renderInfo.DeferredShading);
+	}
 	glCheckError();
 
-	m_oreShader->Use();
-	UpdateUniforms(*m_oreShader);
-	m_greenOrb->Render(*m_oreShader);
-	m_redOrb->Render(*m_oreShader);
+	if (m_renderInfo.DeferredShading)
+		m_gBuffer->BeginGeometry(m_renderTarget->GetWidth(), m_renderTarget->GetHeight());
+
+	GpuTimer& sceneTimer = m_sceneTimers[m_renderInfo.DepthPrePass];
+	sceneTimer.Begin();
+	m_renderQueue.SetViewPosition(m_camera.GetPosition());
+	glm::mat4 viewProjection = m_camera.GetProjectionMatrix() * m_camera.GetViewMatrix();
+	Frustum viewFrustum(viewProjection);
+	m_renderQueue.SetLayerFrustums(&viewFrustum, 1, false);
+
+	// Terrain slabs visible in the last frame are drawn first, the slabs their depth doesn't hide follow
+	bool occlusionCulling = m_renderInfo.GpuCulling && m_renderInfo.OcclusionCulling;
+	if (occlusionCulling)
+		m_commandCuller->SetOcclusion(DrawVisible, m_hiZBuffer, viewProjection);
+
+	if (m_renderInfo.DepthPrePass)
+	{
+		// Depth only, so the expensive terrain shaders run at most once per pixel afterwards
+		glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+		m_mesh->Submit(m_renderQueue, DepthPass, *m_depthPatchShader, *m_depthShader, m_renderInfo.TessellationDistance);
+		m_floor->Submit(m_renderQueue, DepthPass, *m_depthShader);
+		m_renderQueue.Flush();
+		if (occlusionCulling)
+			RenderRevealedTerrain(DepthPass, *m_depthPatchShader, *m_depthShader, viewProjection);
+		glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+
+		glDepthFunc(GL_EQUAL);
+		glDepthMask(GL_FALSE);
+		m_mesh->Submit(m_renderQueue, OpaquePass, *m_geometryShader, *m_geometryFlatShader, m_renderInfo.TessellationDistance);
+		m_floor->Submit(m_renderQueue, OpaquePass, *m_floorShader);
+		m_renderQueue.Flush();
+		glDepthFunc(GL_LESS);
+		glDepthMask(GL_TRUE);
+	}
+	else
+	{
+		m_mesh->Submit(m_renderQueue, OpaquePass, *m_geometryShader, *m_geometryFlatShader, m_renderInfo.TessellationDistance);
+		m_floor->Submit(m_renderQueue, OpaquePass, *m_floorShader);
+		if (occlusionCulling)
+		{
+			m_renderQueue.Flush();
+			RenderRevealedTerrain(OpaquePass, *m_geometryShader, *m_geometryFlatShader, viewProjection);
+		}
+	}
+
+	m_greenOrb->Submit(m_renderQueue, OpaquePass, *m_oreShader);
+	m_redOrb->Submit(m_renderQueue, OpaquePass, *m_oreShader);
+	m_renderQueue.Flush();
+	m_renderQueue.ClearLayerFrustums();
+	m_commandCuller->SetOcclusion(IgnoreOcclusion, nullptr, viewProjection);
+	sceneTimer.End();
+	m_renderInfo.ScenePassTimes[m_renderInfo.DepthPrePass] = sceneTimer.GetMilliseconds();
 	glCheckError();
 
-	m_floorShader->Use();
-	UpdateUniforms(*m_floorShader);
-	m_floor->Render(*m_floorShader);
+	if (m_renderInfo.DeferredShading)
+	{
+		m_gBuffer->EndGeometry(m_renderTarget->GetFramebuffer());
+
+		// Decorations and debug geometry stay forward and depth test against the lit terrain
+		glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
+		m_gBuffer->RenderLighting(m_frameUniforms, m_camera.GetProjectionMatrix() * m_camera.GetViewMatrix());
+		if (m_renderInfo.WireFrameMode)
+			glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
+	}
+
+	m_decorationShader->Use();
+	m_frameUniforms.BindShadowSamplers(*m_decorationShader);
+	m_generator.GetScatter().Render(*m_decorationShader);
 	glCheckError();
 
 	m_debugShader->Use();
-	UpdateUniforms(*m_debugShader);
 	glCheckError();
 
 	glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
@@ -253,9 +363,12 @@ void Engine::Loop()
 
 		Update(deltaTime);
 
+		UpdateRenderScale();
+		m_frameTimer.Begin();
+
 		RenderLights();
 
-		glViewport(0, 0, SCREEN_WIDTH, SCREEN_HEIGHT);
+		m_renderTarget->Bind();
 		glClearColor(.1f, .1f, .1f, 1.0f);
 		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
@@ -263,6 +376,9 @@ void Engine::Loop()
 
 		m_particleSystem.Render(m_renderInfo);
 
+		m_renderTarget->Present(SCREEN_WIDTH, SCREEN_HEIGHT, m_renderInfo.AntiAliasing.Fxaa);
+		m_frameTimer.End();
+
 		RenderHud();
 		glCheckError();
 
@@ -283,60 +399,87 @@ void Engine::Loop()
 	glfwTerminate();
 }
 
-void Engine::RenderLights()
+void Engine::RenderRevealedTerrain(RenderPass pass, Shader& patchShader, Shader& flatShader, const glm::mat4& viewProjection)
 {
-	glCullFace(GL_FRONT);
-	for (std::vector<Light*>::const_iterator it = m_lights.begin(); it != m_lights.end(); ++it)
-	{
-		if (!(*it)->CastsShadows() || !(*it)->IsEnabled())
-			continue;
-
-		(*it)->PreRender();
-		glEnable(GL_CULL_FACE);
-		m_mesh->Render((*it)->GetShadowShader(), false);
-		glDisable(GL_CULL_FACE);
-		m_floor->Render((*it)->GetShadowShader());
-		(*it)->PostRender();
-	}
-	glCullFace(GL_BACK);
+	// Allocated at the target size, so scale changes don't reallocate the pyramid
+	m_hiZBuffer->Build(m_renderTarget->GetWidth(), m_renderTarget->GetHeight(), m_renderTarget->GetViewportWidth(), m_renderTarget->GetViewportHeight());
+
+	m_commandCuller->SetOcclusion(DrawRevealed, m_hiZBuffer, viewProjection);
+	m_mesh->Submit(m_renderQueue, pass, patchShader, flatShader, m_renderInfo.TessellationDistance);
+	m_renderQueue.Flush();
+
+	// The test stored the visibility of this frame, later passes draw exactly the visible slabs
+	m_commandCuller->SetOcclusion(DrawVisible, m_hiZBuffer, viewProjection);
 }
 
-void Engine::UpdateUniforms(const Shader& shader) const
+void Engine::UpdateRenderScale()
 {
-	for (int i = 0; i < m_lights.size(); ++i)
+	m_renderInfo.FrameTime = m_frameTimer.GetMilliseconds();
+	m_renderInfo.RenderScale = m_renderInfo.DynamicResolution ? m_resolutionGovernor.Update(m_renderInfo.FrameTime) : m_renderInfo.MaxRenderScale;
+	m_renderTarget->SetScale(m_renderInfo.RenderScale);
+}
+
+void Engine::RenderLights()
+{
+	if (m_shadowGeneration != m_generator.GetMeshGeneration())
 	{
-		m_lights[i]->UpdateUniforms(shader, i, MaxTexturesPerModel + i);
+		m_shadowScheduler.InvalidateAll();
+		m_shadowGeneration = m_generator.GetMeshGeneration();
 	}
 
-	glm::vec3 viewPos = m_camera.GetPosition();
-	GLuint viewPosLocation = glGetUniformLocation(shader.Program, "viewPos");
-	glUniform3fv(viewPosLocation, 1, glm::value_ptr(viewPos));
-	glCheckError();
-
 	glm::mat4 view = m_camera.GetViewMatrix();
-	GLuint viewLocation = glGetUniformLocation(shader.Program, "view");
-	glUniformMatrix4fv(viewLocation, 1, GL_FALSE, glm::value_ptr(view));
-	glCheckError();
+	glm::mat4 projection = m_camera.GetProjectionMatrix();
+	for (std::vector<Light*>::const_iterator it = m_lights.begin(); it != m_lights.end(); ++it)
+		(*it)->FitToView(view, projection, m_renderInfo);
 
-	glm::mat4 proj = m_camera.GetProjectionMatrix();
-	GLuint projLocation = glGetUniformLocation(shader.Program, "projection");
-	glUniformMatrix4fv(projLocation, 1, GL_FALSE, glm::value_ptr(proj));
-	glCheckError();
+	// Lights whose tiles moved or resized have to be rendered again before their tiles are sampled
+	std::vector<Light*> changed;
+	m_shadowAtlas->Allocate(m_lights, view, projection, m_renderInfo, changed);
+	for (std::vector<Light*>::const_iterator it = changed.begin(); it != changed.end(); ++it)
+		m_shadowScheduler.Relocate(*it);
 
-	GLuint bumbinessLocation = glGetUniformLocation(shader.Program, "bumbiness");
-	glUniform1f(bumbinessLocation, m_renderInfo.NormalMapFactor);
-	glCheckError();
+	m_shadowScheduler.SetFacesPerFrame(m_renderInfo.ShadowFacesPerFrame);
+	m_shadowScheduler.SetBudget(m_renderInfo.ShadowBudget);
+	m_shadowScheduler.Schedule(m_lights, m_shadowUpdates);
 
-	GLuint initialStepsLocation = glGetUniformLocation(shader.Program, "displacement_initialSteps");
-	glUniform1i(initialStepsLocation, m_renderInfo.DisplacementInitialSteps);
-	glCheckError();
+	std::vector<const BaseObject*> casters;
+	casters.push_back(m_mesh);
+	casters.push_back(m_floor);
 
-	GLuint refinementStepsLocation = glGetUniformLocation(shader.Program, "displacement_refinementSteps");
-	glUniform1i(refinementStepsLocation, m_renderInfo.DisplacementRefinementSteps);
-	glCheckError();
+	m_shadowScheduler.BeginTiming();
+	m_shadowAtlas->BeginRender();
+	glCullFace(GL_FRONT);
+	for (std::vector<ShadowUpdate>::const_iterator it = m_shadowUpdates.begin(); it != m_shadowUpdates.end(); ++it)
+	{
+		it->Source->RenderShadowMap(it->FaceMask, *m_shadowAtlas, m_renderQueue, casters);
+		m_shadowAtlas->BlurTiles(it->Source->GetShadowTiles(), it->FaceMask, m_renderInfo.VsmBlurRadius);
+	}
+	glCullFace(GL_BACK);
+	m_shadowAtlas->EndRender();
+	m_shadowScheduler.EndTiming();
+}
 
-	GLuint scaleLocation = glGetUniformLocation(shader.Program, "displacement_scale");
-	glUniform1f(scaleLocation, m_renderInfo.DisplacementScale);
+void Engine::UpdateFrameUniforms()
+{
+	FrameData frame = {};
+	frame.View = m_camera.GetViewMatrix();
+	frame.Projection = m_camera.GetProjectionMatrix();
+	frame.ViewPos = m_camera.GetPosition();
+	frame.Bumpiness = m_renderInfo.NormalMapFactor;
+	frame.DisplacementInitialSteps = m_renderInfo.DisplacementInitialSteps;
+	frame.DisplacementRefinementSteps = m_renderInfo.DisplacementRefinementSteps;
+	frame.DisplacementScale = m_renderInfo.DisplacementScale;
+	frame.BlendThreshold = m_renderInfo.TriplanarBlendThreshold;
+	frame.DominantAxisDistance = m_renderInfo.TriplanarDominantAxisOnly ? m_renderInfo.TriplanarDominantAxisDistance : 0.0f;
+
+	frame.ClusteredLighting = m_renderInfo.ClusteredLighting;
+	frame.ViewportSize = glm::vec2(m_renderTarget->GetViewportWidth(), m_renderTarget->GetViewportHeight());
+	frame.TessellationDistance = m_renderInfo.TessellationDistance;
+	m_lightClusters->WriteFrameData(frame, frame.Projection, m_renderTarget->GetViewportWidth(), m_renderTarget->GetViewportHeight());
+
+	m_frameUniforms.Update(frame, m_lights, *m_shadowAtlas, MaxTexturesPerModel);
+	if (m_renderInfo.ClusteredLighting)
+		m_lightClusters->Assign(frame.Projection);
 	glCheckError();
 }
 
@@ -393,6 +536,9 @@ void Engine::m_KeyCallback(GLFWwindow* window, int key, int scancode, int action
 
 			for (std::vector<Light*>::const_iterator it = m_lights.begin(); it != m_lights.end(); ++it)
 				(*it)->SetShadowMode(m_renderInfo.ShadowMode);
+			m_shadowAtlas->SetShadowMode(m_renderInfo.ShadowMode);
+			// Switching to or from VSM reallocates the atlas
+			m_shadowScheduler.InvalidateAll();
 		} break;
 
 		case GLFW_KEY_F2:
@@ -405,6 +551,106 @@ void Engine::m_KeyCallback(GLFWwindow* window, int key, int scancode, int action
 			m_renderInfo.WireFrameMode = !m_renderInfo.WireFrameMode;
 		} break;
 
+		case GLFW_KEY_F4:
+		{
+			m_renderInfo.EnableDecorations = !m_renderInfo.EnableDecorations;
+			m_generator.GetScatter().IsEnabled(m_renderInfo.EnableDecorations);
+			m_generator.GenerateDecorations();
+		} break;
+
+		case GLFW_KEY_F5:
+		{
+			if (action == GLFW_PRESS)
+				MeshExporter::Export(*m_mesh, "terrain_" + std::to_string(m_renderInfo.Seed) + MeshExporter::GetExtension(m_renderInfo.ExportFormat), m_renderInfo.ExportFormat);
+		} break;
+
+		case GLFW_KEY_F6:
+		{
+			m_renderInfo.ExportFormat = static_cast<MeshFormat>(m_renderInfo.ExportFormat + 1);
+			if (m_renderInfo.ExportFormat > RawFormat)
+				m_renderInfo.ExportFormat = PlyFormat;
+		} break;
+
+		case GLFW_KEY_F7:
+		{
+			if (action != GLFW_PRESS)
+				break;
+			// Regenerate once with the case histogram enabled and dump everything
+			m_generator.SetCollectStatistics(true);
+			m_generator.Generate3dTexture();
+			m_mesh = m_generator.GenerateMesh();
+			m_generator.SetCollectStatistics(false);
+			m_generator.GetStatistics().WriteJson("generator_statistics.json");
+		} break;
+
+		case GLFW_KEY_F8:
+		{
+			m_renderInfo.TriplanarDominantAxisOnly = !m_renderInfo.TriplanarDominantAxisOnly;
+		} break;
+
+		case GLFW_KEY_F9:
+		{
+			m_renderInfo.PointShadowMode = static_cast<PointShadowMode>(m_renderInfo.PointShadowMode + 1);
+			if (m_renderInfo.PointShadowMode > DualParaboloidShadows)
+				m_renderInfo.PointShadowMode = GeometryShaderShadows;
+
+			for (std::vector<Light*>::const_iterator it = m_lights.begin(); it != m_lights.end(); ++it)
+			{
+				if ((*it)->GetType() == Point)
+					static_cast<PointLight*>(*it)->SetPointShadowMode(m_renderInfo.PointShadowMode);
+			}
+			// Face count and layout of the maps changed
+			m_shadowScheduler.InvalidateAll();
+		} break;
+
+		case GLFW_KEY_F10:
+		{
+			m_renderInfo.ClusteredLighting = !m_renderInfo.ClusteredLighting;
+		} break;
+
+		case GLFW_KEY_F11:
+		{
+			if (m_lightSwarm)
+				m_lightSwarm->IsEnabled(!m_lightSwarm->IsEnabled());
+		} break;
+
+		case GLFW_KEY_F12:
+		{
+			m_renderInfo.DeferredShading = !m_renderInfo.DeferredShading;
+		} break;
+
+		case GLFW_KEY_Z:
+		{
+			m_renderInfo.DepthPrePass = !m_renderInfo.DepthPrePass;
+		} break;
+
+		case GLFW_KEY_M:
+		{
+			m_renderInfo.AntiAliasing.NextSampleCount();
+			m_renderTarget->Resize(SCREEN_WIDTH, SCREEN_HEIGHT, m_renderInfo.AntiAliasing.ActiveSamples);
+		} break;
+
+		case GLFW_KEY_F:
+		{
+			m_renderInfo.AntiAliasing.Fxaa = !m_renderInfo.AntiAliasing.Fxaa;
+		} break;
+
+		case GLFW_KEY_C:
+		{
+			m_renderInfo.GpuCulling = !m_renderInfo.GpuCulling;
+			m_renderQueue.SetCommandCuller(m_renderInfo.GpuCulling ? m_commandCuller : nullptr);
+		} break;
+
+		case GLFW_KEY_O:
+		{
+			m_renderInfo.OcclusionCulling = !m_renderInfo.OcclusionCulling;
+		} break;
+
+		case GLFW_KEY_R:
+		{
+			m_renderInfo.DynamicResolution = !m_renderInfo.DynamicResolution;
+		} break;
+
 		case GLFW_KEY_P:
 		{
 			m_updateInfo.IsPaused = !m_updateInfo.IsPaused;
@@ -507,6 +753,7 @@ void Engine::m_ResizeCallback(GLFWwindow* window, int width, int height)
 	SCREEN_WIDTH = width;
 	SCREEN_HEIGHT = height;
 	glViewport(0, 0, SCREEN_WIDTH, SCREEN_HEIGHT);
+	m_renderTarget->Resize(SCREEN_WIDTH, SCREEN_HEIGHT, m_renderInfo.AntiAliasing.ActiveSamples);
 }
 
 Engine* Engine::m_instance = nullptr;
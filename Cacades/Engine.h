@@ -12,6 +12,19 @@
 #include "ParticleSystem.h"
 #include "Camera.h"
 #include "Icosahedron.h"
+#include "FrameUniforms.h"
+#include "RenderQueue.h"
+#include "ShadowScheduler.h"
+#include "ShadowAtlas.h"
+#include "LightClusters.h"
+#include "GBuffer.h"
+#include "GpuTimer.h"
+#include "RenderTarget.h"
+#include "ResolutionGovernor.h"
+#include "CommandCuller.h"
+#include "HiZBuffer.h"
+
+class LightSwarm;
 
 class Light;
 class Hud;
@@ -40,9 +53,16 @@ public:
 	void RenderHud();
 	void Start();
 	void AddLight(Light& light);
+	// Adds the lights of the swarm, spread over the generated geometry
+	void AddLightSwarm(LightSwarm& swarm);
 protected:
+	// Lets the governor pick the scene resolution from the GPU time of the previous frames
+	void UpdateRenderScale();
 	void RenderLights();
-	void UpdateUniforms(const Shader& shader) const;
+	// Second occlusion phase: builds the Hi-Z pyramid from the depth drawn so far and draws the
+	// terrain slabs it reveals
+	void RenderRevealedTerrain(RenderPass pass, Shader& patchShader, Shader& flatShader, const glm::mat4& viewProjection);
+	void UpdateFrameUniforms();
 	void MoveActiveObject();
 	void m_KeyCallback(GLFWwindow* window, int key, int scancode, int action, int mode);
 	void m_CursorPosCallback(GLFWwindow* window, double x, double y);
@@ -55,11 +75,31 @@ protected:
 	Hud* m_hud;
 	GLFWwindow& m_window;
 	Shader* m_geometryShader;
+	Shader* m_geometryFlatShader;
 	Shader* m_oreShader;
 	Shader* m_floorShader;
 	Shader* m_debugShader;
+	Shader* m_decorationShader;
+	Shader* m_depthShader;
+	Shader* m_depthPatchShader;
 	Camera m_camera;
 	std::vector<Light*> m_lights;
+	FrameUniforms m_frameUniforms;
+	RenderQueue m_renderQueue;
+	ShadowScheduler m_shadowScheduler;
+	ShadowAtlas* m_shadowAtlas;
+	LightClusters* m_lightClusters;
+	GBuffer* m_gBuffer;
+	CommandCuller* m_commandCuller;
+	HiZBuffer* m_hiZBuffer;
+	RenderTarget* m_renderTarget;
+	ResolutionGovernor m_resolutionGovernor;
+	GpuTimer m_frameTimer;
+	// Scene pass without and with depth pre-pass
+	GpuTimer m_sceneTimers[2];
+	LightSwarm* m_lightSwarm;
+	std::vector<ShadowUpdate> m_shadowUpdates;
+	GLuint m_shadowGeneration;
 
 	ProcedualGenerator m_generator;
 	ParticleSystem m_particleSystem;
@@ -5,7 +5,9 @@
 #include "shaders/EnumLightType.glh"
 #include "shaders/EnumParticleType.glh"
 #include "shaders/EnumShadowMode.glh"
+#include "shaders/EnumPointShadowMode.glh"
 #include "shaders/EnumDisplacementMode.glh"
+#include "shaders/EnumDecorationType.glh"
 
 enum DisplacementMode
 {
@@ -58,4 +60,25 @@ enum ShadowMode
 	HardShadows = HARD_SHADOWS,
 	PcfShadows = PCF_SHADOWS,
 	VsmShadows = VSM_SHADOWS,
-};
\ No newline at end of file
+};
+
+// How point lights render their omnidirectional shadow map
+enum PointShadowMode
+{
+	GeometryShaderShadows = POINT_SHADOW_GEOMETRY_SHADER,
+	FaceCulledShadows = POINT_SHADOW_FACE_CULLED,
+	DualParaboloidShadows = POINT_SHADOW_DUAL_PARABOLOID,
+};
+
+enum DecorationType
+{
+	RockDecoration = DECORATION_ROCK,
+	CrystalDecoration = DECORATION_CRYSTAL,
+	MossDecoration = DECORATION_MOSS,
+};
+enum MeshFormat
+{
+	PlyFormat,
+	GltfFormat,
+	RawFormat,
+};
@@ -0,0 +1,82 @@
+#include "FrameUniforms.h"
+#include "Global.h"
+#include "Light.h"
+#include "Shader.h"
+#include "ShadowAtlas.h"
+#include <cstring>
+
+static_assert(sizeof(FrameData) == 208, "FrameData has to match the std140 layout of shaders/FrameData.glh");
+static_assert(sizeof(LightData) == 432, "LightData has to match the std430 layout of shaders/Lighting.glh");
+
+// LightCount is padded to the 16 byte alignment of the Lights array
+static const GLsizeiptr LIGHT_HEADER_SIZE = 16;
+
+FrameUniforms::FrameUniforms() : m_lightBufferSize(0), m_firstShadowUnit(0)
+{
+	glGenBuffers(1, &m_frameBuffer);
+	glBindBuffer(GL_UNIFORM_BUFFER, m_frameBuffer);
+	glBufferData(GL_UNIFORM_BUFFER, sizeof(FrameData), nullptr, GL_DYNAMIC_DRAW);
+	glBindBuffer(GL_UNIFORM_BUFFER, 0);
+	glBindBufferBase(GL_UNIFORM_BUFFER, FRAME_DATA_BINDING, m_frameBuffer);
+	glCheckError();
+
+	glGenBuffers(1, &m_lightBuffer);
+	glCheckError();
+}
+
+FrameUniforms::~FrameUniforms()
+{
+	glDeleteBuffers(1, &m_frameBuffer);
+	glDeleteBuffers(1, &m_lightBuffer);
+}
+
+void FrameUniforms::Update(const FrameData& frame, const std::vector<Light*>& lights, const ShadowAtlas& shadowAtlas, GLuint firstShadowUnit)
+{
+	glBindBuffer(GL_UNIFORM_BUFFER, m_frameBuffer);
+	void* data = glMapBufferRange(GL_UNIFORM_BUFFER, 0, sizeof(FrameData), GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+	if (data)
+	{
+		memcpy(data, &frame, sizeof(FrameData));
+		glUnmapBuffer(GL_UNIFORM_BUFFER);
+	}
+	glBindBuffer(GL_UNIFORM_BUFFER, 0);
+	glCheckError();
+
+	UpdateLights(lights);
+
+	m_firstShadowUnit = firstShadowUnit;
+	shadowAtlas.Bind(m_firstShadowUnit, m_firstShadowUnit + 1);
+}
+
+void FrameUniforms::UpdateLights(const std::vector<Light*>& lights)
+{
+	GLsizeiptr size = LIGHT_HEADER_SIZE + lights.size() * sizeof(LightData);
+
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_lightBuffer);
+	if (size > m_lightBufferSize)
+	{
+		m_lightBufferSize = size;
+		glBufferData(GL_SHADER_STORAGE_BUFFER, m_lightBufferSize, nullptr, GL_DYNAMIC_DRAW);
+		glBindBufferBase(GL_SHADER_STORAGE_BUFFER, LIGHT_DATA_BINDING, m_lightBuffer);
+	}
+
+	GLubyte* data = static_cast<GLubyte*>(glMapBufferRange(GL_SHADER_STORAGE_BUFFER, 0, m_lightBufferSize, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT));
+	if (data)
+	{
+		*reinterpret_cast<GLint*>(data) = GLint(lights.size());
+
+		LightData* lightData = reinterpret_cast<LightData*>(data + LIGHT_HEADER_SIZE);
+		for (size_t i = 0; i < lights.size(); ++i)
+			lights[i]->WriteLightData(lightData[i]);
+		glUnmapBuffer(GL_SHADER_STORAGE_BUFFER);
+	}
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+	glCheckError();
+}
+
+void FrameUniforms::BindShadowSamplers(const Shader& shader) const
+{
+	shader.SetInt("ShadowAtlas", m_firstShadowUnit);
+	shader.SetInt("ShadowMomentAtlas", m_firstShadowUnit + 1);
+	glCheckError();
+}
@@ -0,0 +1,91 @@
+#pragma once
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+#include <vector>
+
+class Light;
+class Shader;
+class ShadowAtlas;
+
+// Mirrors the std140 FrameData block in shaders/FrameData.glh
+struct FrameData
+{
+	glm::mat4 View;
+	glm::mat4 Projection;
+	glm::vec3 ViewPos;
+
+	GLfloat Bumpiness;
+	GLint DisplacementInitialSteps;
+	GLint DisplacementRefinementSteps;
+	GLfloat DisplacementScale;
+
+	GLfloat BlendThreshold;
+	GLfloat DominantAxisDistance;
+
+	GLuint ClusteredLighting;
+	GLfloat ClusterScale;
+	GLfloat ClusterBias;
+	glm::vec2 ClusterTileSize;
+	glm::vec2 ViewportSize;
+
+	GLfloat TessellationDistance;
+	// std140 rounds the block size up to a multiple of 16 bytes
+	GLfloat Padding[3];
+};
+
+// Mirrors the std430 LightSource struct in shaders/Lighting.glh
+struct LightData
+{
+	// Has to match MAX_CASCADES in shaders/Lighting.glh
+	static const int MAX_CASCADES = 4;
+	// Has to match MAX_SHADOW_TILES in shaders/Lighting.glh, the six faces of a cube map
+	static const int MAX_SHADOW_TILES = 6;
+
+	// One per cascade, lights without cascades only use the first
+	glm::mat4 LightSpaceMatrices[MAX_CASCADES];
+	// View depth at which each cascade ends
+	glm::vec4 CascadeSplits;
+	// Offset (xy) and scale (zw) of the shadow atlas tile of each face
+	glm::vec4 AtlasRects[MAX_SHADOW_TILES];
+
+	glm::vec3 Pos;
+	GLint Type;
+	glm::vec3 Color;
+	GLint ShadowType;
+
+	GLuint IsEnabled;
+	GLuint CastShadow;
+	GLfloat NearPlane;
+	GLfloat FarPlane;
+
+	// PointShadowMode of point lights
+	GLint ShadowProjection;
+	GLint CascadeCount;
+	GLint Padding[2];
+};
+
+// Per-frame camera and light state shared by all scene shaders.
+// Written once per frame with a single mapped update each and bound to fixed binding points,
+// so the cost no longer grows with the number of shaders.
+class FrameUniforms
+{
+public:
+	FrameUniforms();
+	~FrameUniforms();
+
+	// Binds the depth of the shadow atlas to firstShadowUnit and its moments to the unit after it
+	void Update(const FrameData& frame, const std::vector<Light*>& lights, const ShadowAtlas& shadowAtlas, GLuint firstShadowUnit);
+	// Points the shadow atlas samplers of the shader to the units bound by Update
+	void BindShadowSamplers(const Shader& shader) const;
+
+	static const GLuint FRAME_DATA_BINDING = 0;
+	static const GLuint LIGHT_DATA_BINDING = 4;
+
+protected:
+	void UpdateLights(const std::vector<Light*>& lights);
+
+	GLuint m_frameBuffer;
+	GLuint m_lightBuffer;
+	GLsizeiptr m_lightBufferSize;
+	GLuint m_firstShadowUnit;
+};
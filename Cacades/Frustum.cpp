@@ -0,0 +1,64 @@
+#include "Frustum.h"
+#include <limits>
+
+Frustum::Frustum() : m_planeCount(0)
+{
+}
+
+Frustum::Frustum(const glm::mat4& viewProjection) : m_planeCount(0)
+{
+	// Gribb/Hartmann: each plane is the fourth row plus or minus one of the others
+	glm::mat4 m = glm::transpose(viewProjection);
+	for (int i = 0; i < 3; ++i)
+	{
+		AddPlane(m[3] + m[i]);
+		AddPlane(m[3] - m[i]);
+	}
+}
+
+void Frustum::AddPlane(glm::vec4 plane)
+{
+	if (m_planeCount == MAX_PLANES)
+		return;
+
+	m_planes[m_planeCount++] = plane / glm::length(glm::vec3(plane));
+}
+
+bool Frustum::Intersects(glm::vec3 boundsMin, glm::vec3 boundsMax) const
+{
+	for (int i = 0; i < m_planeCount; ++i)
+	{
+		// Corner furthest along the plane normal
+		glm::vec3 normal(m_planes[i]);
+		glm::vec3 corner(normal.x >= 0 ? boundsMax.x : boundsMin.x,
+			normal.y >= 0 ? boundsMax.y : boundsMin.y,
+			normal.z >= 0 ? boundsMax.z : boundsMin.z);
+
+		if (glm::dot(normal, corner) + m_planes[i].w < 0)
+			return false;
+	}
+	return true;
+}
+
+int Frustum::GetPlaneCount() const
+{
+	return m_planeCount;
+}
+
+glm::vec4 Frustum::GetPlane(int index) const
+{
+	return m_planes[index];
+}
+
+void Frustum::TransformBounds(const glm::mat4& matrix, glm::vec3 boundsMin, glm::vec3 boundsMax, glm::vec3& outMin, glm::vec3& outMax)
+{
+	outMin = glm::vec3(std::numeric_limits<float>::max());
+	outMax = glm::vec3(-std::numeric_limits<float>::max());
+	for (int i = 0; i < 8; ++i)
+	{
+		glm::vec3 corner(i & 1 ? boundsMax.x : boundsMin.x, i & 2 ? boundsMax.y : boundsMin.y, i & 4 ? boundsMax.z : boundsMin.z);
+		glm::vec3 transformed(matrix * glm::vec4(corner, 1.0f));
+		outMin = glm::min(outMin, transformed);
+		outMax = glm::max(outMax, transformed);
+	}
+}
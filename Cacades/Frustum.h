@@ -0,0 +1,27 @@
+#pragma once
+#include <glm/glm.hpp>
+
+// Convex volume bounded by up to MAX_PLANES planes.
+// Planes are stored as (normal, distance) with the normal pointing inside.
+class Frustum
+{
+public:
+	Frustum();
+	// Extracts the six clip planes of a view projection matrix
+	explicit Frustum(const glm::mat4& viewProjection);
+
+	void AddPlane(glm::vec4 plane);
+	// Conservative, false only if the box lies completely outside of one plane
+	bool Intersects(glm::vec3 boundsMin, glm::vec3 boundsMax) const;
+	int GetPlaneCount() const;
+	glm::vec4 GetPlane(int index) const;
+
+	// Axis aligned bounds of the transformed box
+	static void TransformBounds(const glm::mat4& matrix, glm::vec3 boundsMin, glm::vec3 boundsMax, glm::vec3& outMin, glm::vec3& outMax);
+
+	static const int MAX_PLANES = 6;
+
+protected:
+	glm::vec4 m_planes[MAX_PLANES];
+	int m_planeCount;
+};
@@ -0,0 +1,113 @@
+#include "GBuffer.h"
+#include "FrameUniforms.h"
+#include "Global.h"
+#include "Shader.h"
+
+GBuffer::GBuffer() : m_fbo(0), m_albedo(0), m_normal(0), m_depth(0), m_vao(0), m_width(0), m_height(0)
+{
+	m_lightingShader = new Shader("./shaders/Fullscreen.vert", nullptr, "./shaders/DeferredLighting.frag");
+	m_lightingShader->Test("DeferredLighting");
+
+	// The fullscreen triangle is generated from gl_VertexID
+	glGenVertexArrays(1, &m_vao);
+	glGenFramebuffers(1, &m_fbo);
+	glCheckError();
+}
+
+GBuffer::~GBuffer()
+{
+	Delete();
+	glDeleteFramebuffers(1, &m_fbo);
+	glDeleteVertexArrays(1, &m_vao);
+	delete m_lightingShader;
+}
+
+void GBuffer::BeginGeometry(GLsizei width, GLsizei height)
+{
+	if (width != m_width || height != m_height)
+		Allocate(width, height);
+
+	glBindFramebuffer(GL_FRAMEBUFFER, m_fbo);
+	glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
+	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+	glCheckError();
+}
+
+void GBuffer::EndGeometry(GLuint framebuffer) const
+{
+	glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+}
+
+void GBuffer::RenderLighting(const FrameUniforms& frameUniforms, const glm::mat4& viewProjection) const
+{
+	m_lightingShader->Use();
+	frameUniforms.BindShadowSamplers(*m_lightingShader);
+	m_lightingShader->SetInt("gAlbedo", FIRST_UNIT);
+	m_lightingShader->SetInt("gNormal", FIRST_UNIT + 1);
+	m_lightingShader->SetInt("gDepth", FIRST_UNIT + 2);
+	m_lightingShader->SetMat4("inverseViewProjection", glm::inverse(viewProjection));
+	glCheckError();
+
+	glActiveTexture(GL_TEXTURE0 + FIRST_UNIT);
+	glBindTexture(GL_TEXTURE_2D, m_albedo);
+	glActiveTexture(GL_TEXTURE0 + FIRST_UNIT + 1);
+	glBindTexture(GL_TEXTURE_2D, m_normal);
+	glActiveTexture(GL_TEXTURE0 + FIRST_UNIT + 2);
+	glBindTexture(GL_TEXTURE_2D, m_depth);
+	glCheckError();
+
+	// Every pixel writes the depth of the G-buffer, so forward passes afterwards still depth test
+	glDepthFunc(GL_ALWAYS);
+	GLboolean cullFace = glIsEnabled(GL_CULL_FACE);
+	glDisable(GL_CULL_FACE);
+	glBindVertexArray(m_vao);
+	glDrawArrays(GL_TRIANGLES, 0, 3);
+	glBindVertexArray(0);
+	if (cullFace)
+		glEnable(GL_CULL_FACE);
+	glDepthFunc(GL_LESS);
+	glCheckError();
+}
+
+void GBuffer::Allocate(GLsizei width, GLsizei height)
+{
+	Delete();
+	m_width = width;
+	m_height = height;
+
+	GLuint* textures[] = { &m_albedo, &m_normal, &m_depth };
+	GLenum formats[] = { GL_RGBA8, GL_RGBA16F, GL_DEPTH_COMPONENT32F };
+	for (int i = 0; i < 3; ++i)
+	{
+		glGenTextures(1, textures[i]);
+		glBindTexture(GL_TEXTURE_2D, *textures[i]);
+		glTexStorage2D(GL_TEXTURE_2D, 1, formats[i], m_width, m_height);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	}
+	glBindTexture(GL_TEXTURE_2D, 0);
+	glCheckError();
+
+	glBindFramebuffer(GL_FRAMEBUFFER, m_fbo);
+	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, m_albedo, 0);
+	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT1, GL_TEXTURE_2D, m_normal, 0);
+	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, m_depth, 0);
+	GLenum drawBuffers[] = { GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1 };
+	glDrawBuffers(2, drawBuffers);
+	glCheckError();
+
+	glCheckFrameBuffer();
+
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	glCheckError();
+}
+
+void GBuffer::Delete()
+{
+	glDeleteTextures(1, &m_albedo);
+	glDeleteTextures(1, &m_normal);
+	glDeleteTextures(1, &m_depth);
+	m_albedo = 0;
+	m_normal = 0;
+	m_depth = 0;
+}
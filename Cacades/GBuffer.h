@@ -0,0 +1,39 @@
+#pragma once
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+class FrameUniforms;
+class Shader;
+
+// Targets of the deferred path: albedo with a lighting flag, world space normal and depth.
+// The scene shaders fill it when WriteGBuffer is set (shaders/GBuffer.glh), afterwards a single
+// fullscreen pass runs the regular lighting once per pixel instead of once per rasterized fragment.
+class GBuffer
+{
+public:
+	GBuffer();
+	~GBuffer();
+
+	// Binds and clears the G-buffer, reallocating it when the size changed
+	void BeginGeometry(GLsizei width, GLsizei height);
+	// Rebinds framebuffer, the target of the lighting pass
+	void EndGeometry(GLuint framebuffer) const;
+	// Shades the covered pixels into the bound framebuffer and writes their depth
+	void RenderLighting(const FrameUniforms& frameUniforms, const glm::mat4& viewProjection) const;
+
+	// Units of the G-buffer textures during the lighting pass
+	static const GLuint FIRST_UNIT = 0;
+
+protected:
+	void Allocate(GLsizei width, GLsizei height);
+	void Delete();
+
+	GLuint m_fbo;
+	GLuint m_albedo;
+	GLuint m_normal;
+	GLuint m_depth;
+	GLuint m_vao;
+	GLsizei m_width;
+	GLsizei m_height;
+	Shader* m_lightingShader;
+};
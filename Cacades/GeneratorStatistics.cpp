@@ -0,0 +1,75 @@
+#include "GeneratorStatistics.h"
+#include <fstream>
+#include <iostream>
+
+GLuint GeneratorStatistics::GetTotalTriangles() const
+{
+	GLuint sum = 0;
+	for (std::vector<GLuint>::const_iterator it = SlabTriangles.begin(); it != SlabTriangles.end(); ++it)
+		sum += *it;
+	return sum;
+}
+
+GLuint64 GeneratorStatistics::GetCellCount() const
+{
+	GLuint64 sum = 0;
+	for (int i = 0; i < MC_CASE_COUNT; ++i)
+		sum += CaseHistogram[i];
+	return sum;
+}
+
+double GeneratorStatistics::GetNonEmptyCellRatio() const
+{
+	GLuint64 cells = GetCellCount();
+	if (cells == 0)
+		return 0;
+
+	// Case 0 and 255 are cells that lie completely in- or outside of the surface
+	GLuint64 empty = CaseHistogram[0] + CaseHistogram[MC_CASE_COUNT - 1];
+	return double(cells - empty) / cells;
+}
+
+void GeneratorStatistics::WriteJson(std::ostream& stream) const
+{
+	stream << "{\n";
+
+	stream << "  \"stages\": [\n";
+	for (size_t i = 0; i < Stages.size(); ++i)
+	{
+		stream << "    { \"name\": \"" << Stages[i].Name << "\", \"cpu_ms\": " << Stages[i].CpuMilliseconds
+			<< ", \"gpu_ms\": " << Stages[i].GpuMilliseconds << " }" << (i + 1 < Stages.size() ? "," : "") << "\n";
+	}
+	stream << "  ],\n";
+
+	stream << "  \"total_triangles\": " << GetTotalTriangles() << ",\n";
+	stream << "  \"slab_triangles\": [";
+	for (size_t i = 0; i < SlabTriangles.size(); ++i)
+		stream << (i ? ", " : "") << SlabTriangles[i];
+	stream << "]";
+
+	if (HasCaseHistogram)
+	{
+		stream << ",\n";
+		stream << "  \"cell_count\": " << GetCellCount() << ",\n";
+		stream << "  \"non_empty_cell_ratio\": " << GetNonEmptyCellRatio() << ",\n";
+		stream << "  \"mc_case_histogram\": [";
+		for (int i = 0; i < MC_CASE_COUNT; ++i)
+			stream << (i ? ", " : "") << CaseHistogram[i];
+		stream << "]";
+	}
+	stream << "\n}\n";
+}
+
+bool GeneratorStatistics::WriteJson(const std::string& path) const
+{
+	std::ofstream file(path);
+	if (!file)
+	{
+		std::cout << "ERROR::STATISTICS::FAILED_TO_OPEN " << path << std::endl;
+		return false;
+	}
+
+	WriteJson(file);
+	std::cout << "INFO::STATISTICS written to " << path << std::endl;
+	return true;
+}
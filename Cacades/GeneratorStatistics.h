@@ -0,0 +1,25 @@
+#pragma once
+#include <GL/glew.h>
+#include <ostream>
+#include <string>
+#include <vector>
+#include "StageTimer.h"
+
+struct GeneratorStatistics
+{
+	static const int MC_CASE_COUNT = 256;
+
+	std::vector<StageTiming> Stages;
+	std::vector<GLuint> SlabTriangles;
+
+	// Only filled while statistics collection is enabled, since the atomics slow down the MC pass
+	bool HasCaseHistogram = false;
+	GLuint CaseHistogram[MC_CASE_COUNT] = {};
+
+	GLuint GetTotalTriangles() const;
+	GLuint64 GetCellCount() const;
+	double GetNonEmptyCellRatio() const;
+
+	void WriteJson(std::ostream& stream) const;
+	bool WriteJson(const std::string& path) const;
+};
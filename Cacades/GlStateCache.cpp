@@ -0,0 +1,111 @@
+#include "GlStateCache.h"
+#include "Shader.h"
+#include "Global.h"
+
+// Marks cached values that have to be set on first use
+static const GLuint UNKNOWN = ~0u;
+
+GlStateCache::GlStateCache() : m_stateChanges(0), m_elidedChanges(0)
+{
+	Invalidate();
+}
+
+void GlStateCache::Invalidate()
+{
+	m_shader = nullptr;
+	m_program = UNKNOWN;
+	m_vao = UNKNOWN;
+	m_activeUnit = UNKNOWN;
+	for (GLuint i = 0; i < MAX_TEXTURE_UNITS; ++i)
+		m_textures[i] = UNKNOWN;
+	m_patchVertices = -1;
+	m_cullFace = -1;
+}
+
+bool GlStateCache::Change(bool isRedundant)
+{
+	if (isRedundant)
+		++m_elidedChanges;
+	else
+		++m_stateChanges;
+	return !isRedundant;
+}
+
+void GlStateCache::UseProgram(Shader& shader)
+{
+	// Use() also applies pending hot reloads, which may replace the program name
+	if (!Change(m_shader == &shader && m_program == shader.Program))
+		return;
+
+	shader.Use();
+	m_shader = &shader;
+	m_program = shader.Program;
+}
+
+void GlStateCache::BindVertexArray(GLuint vao)
+{
+	if (!Change(m_vao == vao))
+		return;
+
+	glBindVertexArray(vao);
+	m_vao = vao;
+}
+
+void GlStateCache::BindTexture(GLuint unit, GLenum target, GLuint texture)
+{
+	if (unit >= MAX_TEXTURE_UNITS)
+	{
+		glActiveTexture(GL_TEXTURE0 + unit);
+		glBindTexture(target, texture);
+		m_activeUnit = unit;
+		return;
+	}
+
+	if (!Change(m_textures[unit] == texture))
+		return;
+
+	if (m_activeUnit != unit)
+	{
+		glActiveTexture(GL_TEXTURE0 + unit);
+		m_activeUnit = unit;
+	}
+	glBindTexture(target, texture);
+	m_textures[unit] = texture;
+}
+
+void GlStateCache::SetPatchVertices(GLint count)
+{
+	if (!Change(m_patchVertices == count))
+		return;
+
+	glPatchParameteri(GL_PATCH_VERTICES, count);
+	m_patchVertices = count;
+}
+
+void GlStateCache::SetCullFace(bool enabled)
+{
+	if (!Change(m_cullFace == int(enabled)))
+		return;
+
+	if (enabled)
+		glEnable(GL_CULL_FACE);
+	else
+		glDisable(GL_CULL_FACE);
+	m_cullFace = enabled;
+}
+
+GLuint GlStateCache::GetStateChanges() const
+{
+	return m_stateChanges;
+}
+
+GLuint GlStateCache::GetElidedChanges() const
+{
+	return m_elidedChanges;
+}
+
+void GlStateCache::ResetCounters()
+{
+	m_stateChanges = 0;
+	m_elidedChanges = 0;
+}
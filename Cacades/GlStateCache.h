@@ -0,0 +1,40 @@
+#pragma once
+#include <GL/glew.h>
+
+class Shader;
+
+// Shadows the GL bindings changed while executing a RenderQueue and skips redundant calls.
+// Anything that binds state behind its back has to be followed by Invalidate().
+class GlStateCache
+{
+public:
+	GlStateCache();
+
+	void Invalidate();
+
+	void UseProgram(Shader& shader);
+	void BindVertexArray(GLuint vao);
+	void BindTexture(GLuint unit, GLenum target, GLuint texture);
+	void SetPatchVertices(GLint count);
+	void SetCullFace(bool enabled);
+
+	GLuint GetStateChanges() const;
+	GLuint GetElidedChanges() const;
+	void ResetCounters();
+
+	static const GLuint MAX_TEXTURE_UNITS = 32;
+
+private:
+	bool Change(bool isRedundant);
+
+	Shader* m_shader;
+	GLuint m_program;
+	GLuint m_vao;
+	GLuint m_activeUnit;
+	GLuint m_textures[MAX_TEXTURE_UNITS];
+	GLint m_patchVertices;
+	int m_cullFace;
+
+	GLuint m_stateChanges;
+	GLuint m_elidedChanges;
+};
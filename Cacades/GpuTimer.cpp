@@ -0,0 +1,64 @@
+#include "GpuTimer.h"
+#include "Global.h"
+#include <glm/glm.hpp>
+
+GpuTimer::GpuTimer(float smoothing) : m_queryIndex(0), m_isMeasuring(false), m_milliseconds(0.0f), m_smoothing(smoothing)
+{
+	glGenQueries(4, &m_queries[0][0]);
+	m_queryPending[0] = m_queryPending[1] = false;
+	glCheckError();
+}
+
+GpuTimer::~GpuTimer()
+{
+	glDeleteQueries(4, &m_queries[0][0]);
+}
+
+void GpuTimer::Begin()
+{
+	Read();
+
+	// The query of two frames ago is still in flight, skip measuring this frame
+	m_isMeasuring = !m_queryPending[m_queryIndex];
+	if (m_isMeasuring)
+		glQueryCounter(m_queries[m_queryIndex][0], GL_TIMESTAMP);
+}
+
+void GpuTimer::End()
+{
+	if (m_isMeasuring)
+	{
+		glQueryCounter(m_queries[m_queryIndex][1], GL_TIMESTAMP);
+		m_queryPending[m_queryIndex] = true;
+		m_isMeasuring = false;
+		glCheckError();
+	}
+	m_queryIndex = 1 - m_queryIndex;
+}
+
+float GpuTimer::GetMilliseconds() const
+{
+	return m_milliseconds;
+}
+
+void GpuTimer::Read()
+{
+	for (int i = 0; i < 2; ++i)
+	{
+		if (!m_queryPending[i])
+			continue;
+
+		GLint available = 0;
+		glGetQueryObjectiv(m_queries[i][1], GL_QUERY_RESULT_AVAILABLE, &available);
+		if (!available)
+			continue;
+
+		GLuint64 start = 0, end = 0;
+		glGetQueryObjectui64v(m_queries[i][0], GL_QUERY_RESULT, &start);
+		glGetQueryObjectui64v(m_queries[i][1], GL_QUERY_RESULT, &end);
+		m_queryPending[i] = false;
+
+		float time = float((end - start) / 1e6);
+		m_milliseconds = m_milliseconds == 0.0f ? time : glm::mix(m_milliseconds, time, m_smoothing);
+	}
+}
@@ -0,0 +1,30 @@
+#pragma once
+#include <GL/glew.h>
+
+// Measures the GPU time spent between Begin and End without stalling.
+// Timestamps instead of GL_TIME_ELAPSED let timers nest, e.g. the scene pass inside the whole frame.
+// Two query pairs alternate, results are read once available and averaged exponentially.
+class GpuTimer
+{
+public:
+	// Weight of a new result in the moving average
+	explicit GpuTimer(float smoothing = 0.1f);
+	~GpuTimer();
+
+	void Begin();
+	void End();
+
+	// Smoothed milliseconds, 0 until the first result arrived
+	float GetMilliseconds() const;
+
+protected:
+	void Read();
+
+	// Start and end timestamp per frame in flight
+	GLuint m_queries[2][2];
+	bool m_queryPending[2];
+	int m_queryIndex;
+	bool m_isMeasuring;
+	float m_milliseconds;
+	float m_smoothing;
+};
@@ -0,0 +1,168 @@
+#include "HiZBuffer.h"
+#include "Global.h"
+#include "Shader.h"
+#include <glm/glm.hpp>
+
+HiZBuffer::HiZBuffer() : m_depthFbo(0), m_depth(0), m_pyramid(0), m_width(0), m_height(0), m_samples(0), m_levelCount(0), m_viewportWidth(0), m_viewportHeight(0), m_viewportLevelCount(0)
+{
+	m_reduceShader = new Shader("./shaders/HiZReduce.comp");
+	m_reduceShader->Test("HiZReduce");
+}
+
+HiZBuffer::~HiZBuffer()
+{
+	Delete();
+	delete m_reduceShader;
+}
+
+void HiZBuffer::Build(GLsizei width, GLsizei height, GLsizei viewportWidth, GLsizei viewportHeight)
+{
+	GLint framebuffer, samples;
+	glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &framebuffer);
+	glGetIntegerv(GL_SAMPLES, &samples);
+	if (width != m_width || height != m_height || samples != m_samples)
+		Allocate(width, height, samples);
+
+	m_viewportWidth = glm::min(viewportWidth, m_width);
+	m_viewportHeight = glm::min(viewportHeight, m_height);
+	m_viewportLevelCount = 1;
+	while ((glm::max(m_viewportWidth, m_viewportHeight) >> m_viewportLevelCount) > 0)
+		++m_viewportLevelCount;
+
+	// Copies every sample, resolving to one of them would hide geometry behind edges the others don't cover
+	glBindFramebuffer(GL_READ_FRAMEBUFFER, framebuffer);
+	glBindFramebuffer(GL_DRAW_FRAMEBUFFER, m_depthFbo);
+	glBlitFramebuffer(0, 0, m_viewportWidth, m_viewportHeight, 0, 0, m_viewportWidth, m_viewportHeight, GL_DEPTH_BUFFER_BIT, GL_NEAREST);
+	glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+	glCheckError();
+
+	m_reduceShader->Use();
+	m_reduceShader->SetInt("source", TEXTURE_UNIT);
+	m_reduceShader->SetInt("multisampledSource", MULTISAMPLE_UNIT);
+	m_reduceShader->SetInt("sampleCount", m_samples);
+	if (m_samples > 0)
+	{
+		glActiveTexture(GL_TEXTURE0 + MULTISAMPLE_UNIT);
+		glBindTexture(GL_TEXTURE_2D_MULTISAMPLE, m_depth);
+	}
+	glActiveTexture(GL_TEXTURE0 + TEXTURE_UNIT);
+	glm::ivec2 sourceSize(m_viewportWidth, m_viewportHeight);
+	for (GLint level = 0; level < m_viewportLevelCount; ++level)
+	{
+		// Level 0 takes the farthest sample of the depth, every further level reduces the one before
+		glBindTexture(GL_TEXTURE_2D, level == 0 && m_samples == 0 ? m_depth : m_pyramid);
+		m_reduceShader->SetInt("sourceLevel", level - 1);
+		glBindImageTexture(0, m_pyramid, level, GL_FALSE, 0, GL_WRITE_ONLY, GL_R32F);
+
+		// Only the part of the level covered by the viewport
+		GLsizei levelWidth = glm::max(m_viewportWidth >> level, 1);
+		GLsizei levelHeight = glm::max(m_viewportHeight >> level, 1);
+		m_reduceShader->SetIVec2("sourceSize", sourceSize);
+		m_reduceShader->SetIVec2("targetSize", glm::ivec2(levelWidth, levelHeight));
+		sourceSize = glm::ivec2(levelWidth, levelHeight);
+		glDispatchCompute((levelWidth + 7) / 8, (levelHeight + 7) / 8, 1);
+		glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT | GL_SHADER_IMAGE_ACCESS_BARRIER_BIT);
+		glCheckError();
+	}
+
+	glBindImageTexture(0, 0, 0, GL_FALSE, 0, GL_WRITE_ONLY, GL_R32F);
+	glBindTexture(GL_TEXTURE_2D, 0);
+	if (m_samples > 0)
+	{
+		glActiveTexture(GL_TEXTURE0 + MULTISAMPLE_UNIT);
+		glBindTexture(GL_TEXTURE_2D_MULTISAMPLE, 0);
+	}
+	glActiveTexture(GL_TEXTURE0);
+	glUseProgram(0);
+	glCheckError();
+}
+
+void HiZBuffer::Bind() const
+{
+	glActiveTexture(GL_TEXTURE0 + TEXTURE_UNIT);
+	glBindTexture(GL_TEXTURE_2D, m_pyramid);
+	glActiveTexture(GL_TEXTURE0);
+}
+
+GLsizei HiZBuffer::GetWidth() const
+{
+	return m_width;
+}
+
+GLsizei HiZBuffer::GetHeight() const
+{
+	return m_height;
+}
+
+GLsizei HiZBuffer::GetViewportWidth() const
+{
+	return m_viewportWidth;
+}
+
+GLsizei HiZBuffer::GetViewportHeight() const
+{
+	return m_viewportHeight;
+}
+
+GLint HiZBuffer::GetLevelCount() const
+{
+	return m_viewportLevelCount;
+}
+
+void HiZBuffer::Allocate(GLsizei width, GLsizei height, GLsizei samples)
+{
+	Delete();
+
+	m_width = width;
+	m_height = height;
+	m_samples = samples;
+	m_levelCount = 1;
+	while ((glm::max(m_width, m_height) >> m_levelCount) > 0)
+		++m_levelCount;
+
+	// Multisampled blits need the same sample count on both sides
+	glGenTextures(1, &m_depth);
+	if (m_samples > 0)
+	{
+		glBindTexture(GL_TEXTURE_2D_MULTISAMPLE, m_depth);
+		glTexStorage2DMultisample(GL_TEXTURE_2D_MULTISAMPLE, m_samples, GL_DEPTH_COMPONENT32F, m_width, m_height, GL_TRUE);
+		glBindTexture(GL_TEXTURE_2D_MULTISAMPLE, 0);
+	}
+	else
+	{
+		glBindTexture(GL_TEXTURE_2D, m_depth);
+		glTexStorage2D(GL_TEXTURE_2D, 1, GL_DEPTH_COMPONENT32F, m_width, m_height);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	}
+
+	glGenTextures(1, &m_pyramid);
+	glBindTexture(GL_TEXTURE_2D, m_pyramid);
+	glTexStorage2D(GL_TEXTURE_2D, m_levelCount, GL_R32F, m_width, m_height);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST_MIPMAP_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	glBindTexture(GL_TEXTURE_2D, 0);
+	glCheckError();
+
+	GLint framebuffer;
+	glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &framebuffer);
+	glGenFramebuffers(1, &m_depthFbo);
+	glBindFramebuffer(GL_FRAMEBUFFER, m_depthFbo);
+	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, m_samples > 0 ? GL_TEXTURE_2D_MULTISAMPLE : GL_TEXTURE_2D, m_depth, 0);
+	glDrawBuffer(GL_NONE);
+	glReadBuffer(GL_NONE);
+	glCheckFrameBuffer();
+	glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+	glCheckError();
+}
+
+void HiZBuffer::Delete()
+{
+	if (m_depthFbo == 0)
+		return;
+
+	glDeleteFramebuffers(1, &m_depthFbo);
+	glDeleteTextures(1, &m_depth);
+	glDeleteTextures(1, &m_pyramid);
+	m_depthFbo = m_depth = m_pyramid = 0;
+}
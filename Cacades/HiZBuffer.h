@@ -0,0 +1,50 @@
+#pragma once
+#include <GL/glew.h>
+
+class Shader;
+
+// Hierarchical depth: every mip level holds the farthest depth of the texels it covers, so a single
+// fetch of the right level tells whether a screen rectangle is completely behind the rendered scene.
+class HiZBuffer
+{
+public:
+	HiZBuffer();
+	~HiZBuffer();
+
+	// Builds the pyramid from the depth of the bound framebuffer within the viewport of the given size.
+	// The storage has the size of the framebuffer and is only reallocated when that or its sample count
+	// changed, so a scaled viewport only builds and covers the lower left part of every level.
+	// The framebuffer stays bound.
+	void Build(GLsizei width, GLsizei height, GLsizei viewportWidth, GLsizei viewportHeight);
+	// Binds the pyramid to TEXTURE_UNIT
+	void Bind() const;
+
+	GLsizei GetWidth() const;
+	GLsizei GetHeight() const;
+	// Pixels of the viewport the last build covered in level 0
+	GLsizei GetViewportWidth() const;
+	GLsizei GetViewportHeight() const;
+	// Levels built for the viewport, down to a single texel
+	GLint GetLevelCount() const;
+
+	static const GLuint TEXTURE_UNIT = 12;
+	// Multisampled depth is read from its own unit while level 0 is built
+	static const GLuint MULTISAMPLE_UNIT = 13;
+
+protected:
+	void Allocate(GLsizei width, GLsizei height, GLsizei samples);
+	void Delete();
+
+	// Copy of the scene depth with the samples of the framebuffer, the source of level 0
+	GLuint m_depthFbo;
+	GLuint m_depth;
+	GLuint m_pyramid;
+	GLsizei m_width;
+	GLsizei m_height;
+	GLsizei m_samples;
+	GLint m_levelCount;
+	GLsizei m_viewportWidth;
+	GLsizei m_viewportHeight;
+	GLint m_viewportLevelCount;
+	Shader* m_reduceShader;
+};
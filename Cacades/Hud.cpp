@@ -33,6 +33,16 @@ void Hud::Update(int fps, const RenderInfo& renderInfo)
 	ss << "  Layer: " << renderInfo.StartLayer << std::endl;
 	ss << "  Resolution: " << renderInfo.Resolution.x << "/" << renderInfo.Resolution.y << "/" << renderInfo.Resolution.z << std::endl;
 	ss << "ShadowMode: " << ((renderInfo.ShadowMode == PcfShadows) ? "PCF" : (renderInfo.ShadowMode == VsmShadows) ? "VSM" : "Hard") << std::endl;
+	ss << "Point Shadows: " << ((renderInfo.PointShadowMode == FaceCulledShadows) ? "Face culled" : (renderInfo.PointShadowMode == DualParaboloidShadows) ? "Dual paraboloid" : "Geometry shader") << std::endl;
+	ss << "Lighting: " << (renderInfo.ClusteredLighting ? "Clustered" : "All lights") << std::endl;
+	ss << "Shading: " << (renderInfo.DeferredShading ? "Deferred" : "Forward") << std::endl;
+	ss << "Depth Pre-Pass: " << (renderInfo.DepthPrePass ? "On" : "Off") << " (off " << renderInfo.ScenePassTimes[0] << " ms, on " << renderInfo.ScenePassTimes[1] << " ms)" << std::endl;
+	ss << "GPU Culling: " << (renderInfo.GpuCulling ? "On" : "Off") << ", Occlusion: " << (renderInfo.OcclusionCulling ? "On" : "Off") << std::endl;
+	ss << "Render Scale: " << renderInfo.RenderScale << (renderInfo.DynamicResolution ? " (Dynamic)" : "") << " GPU " << renderInfo.FrameTime << " ms" << std::endl;
+	ss << "Anti-Aliasing: " << renderInfo.AntiAliasing.ParseAAMode() << std::endl;
+	ss << "Decorations: " << (renderInfo.EnableDecorations ? "On" : "Off") << std::endl;
+	ss << "Export Format: " << ((renderInfo.ExportFormat == PlyFormat) ? "PLY" : (renderInfo.ExportFormat == GltfFormat) ? "glTF" : "Raw") << std::endl;
+	ss << "Triplanar: " << (renderInfo.TriplanarDominantAxisOnly ? "Dominant axis far" : "Full blend") << std::endl;
 	m_infoText.SetString(ss.str());
 }
 
@@ -41,8 +51,7 @@ void Hud::Render() const
 	m_shader.Use();
 
 	glm::mat4 proj = glm::ortho(0.0f, static_cast<GLfloat>(SCREEN_WIDTH), 0.0f, static_cast<GLfloat>(SCREEN_HEIGHT));
-	GLuint projLocation = glGetUniformLocation(m_shader.Program, "projection");
-	glUniformMatrix4fv(projLocation, 1, GL_FALSE, glm::value_ptr(proj));
+	m_shader.SetMat4("projection", proj);
 	glCheckError();
 
 	m_infoText.Render(m_shader);
@@ -28,17 +28,7 @@ void Icosahedron::Update(GLfloat deltaTime)
 
 void Icosahedron::Render(Shader& shader) const
 {
-	GLint modelLoc = glGetUniformLocation(shader.Program, "model");
-	glUniformMatrix4fv(modelLoc, 1, GL_FALSE, glm::value_ptr(GetMatrix()));
-	glCheckError();
-
-	GLint objectColorLoc = glGetUniformLocation(shader.Program, "objectColor");
-	glUniform3fv(objectColorLoc, 1, glm::value_ptr(m_color));
-	glCheckError();
-
-	GLint lightingLoc = glGetUniformLocation(shader.Program, "EnableLighting");
-	glUniform1i(lightingLoc, m_lightingMode);
-	glCheckError();
+	SetDrawUniforms(shader);
 
 	glBindVertexArray(m_vao);
 	glCheckError(); 
@@ -50,6 +40,32 @@ void Icosahedron::Render(Shader& shader) const
 	glBindVertexArray(0);
 }
 
+void Icosahedron::Submit(RenderQueue& queue, RenderPass pass, Shader& shader) const
+{
+	DrawPacket packet;
+	packet.Program = &shader;
+	packet.Object = this;
+	packet.Vao = m_vao;
+	packet.Mode = GL_PATCHES;
+	packet.PatchVertices = 3;
+	packet.Count = m_indexCount;
+	packet.IndexType = GL_UNSIGNED_INT;
+	packet.Position = m_position;
+	queue.Submit(pass, packet);
+}
+
+void Icosahedron::SetDrawUniforms(const Shader& shader) const
+{
+	shader.SetMat4("model", GetMatrix());
+	glCheckError();
+
+	shader.SetVec3("objectColor", m_color);
+	glCheckError();
+
+	shader.SetInt("EnableLighting", m_lightingMode);
+	glCheckError();
+}
+
 void Icosahedron::SetLightingMode(bool isActive)
 {
 	m_lightingMode = isActive;
@@ -9,6 +9,8 @@ public:
 
 	void Update(GLfloat deltaTime) override;
 	void Render(Shader& shader) const override;
+	void Submit(RenderQueue& queue, RenderPass pass, Shader& shader) const override;
+	void SetDrawUniforms(const Shader& shader) const override;
 
 	void SetLightingMode(bool active);
 	void SetColor(glm::vec3 color);
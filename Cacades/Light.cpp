@@ -1,8 +1,9 @@
 #include "Light.h"
-#include "Shader.h"
+#include "FrameUniforms.h"
+#include "Global.h"
 
 Light::Light(glm::vec3 position, glm::quat orientation, glm::vec3 color, Shader& shadowShader, int nearPlane, int farPlane) : BaseObject(position, orientation), 
-m_color(color), shadowMap(0), shadowMapFBO(0), m_shadowShader(shadowShader), 
+m_color(color), m_atlasSize(1), m_shadowShader(shadowShader), 
 m_shadowMode(PcfShadows), m_farPlane(farPlane), m_nearPlane(nearPlane), m_castShadow(true), m_debugCube(nullptr)
 {
 }
@@ -11,69 +12,66 @@ Light::~Light()
 {
 }
 
-void Light::UpdateUniforms(const Shader& shader, int lightIndex, int textureIndex)
+void Light::WriteLightData(LightData& data)
 {
-	GLint posLoc = glGetUniformLocation(shader.Program, ("Lights[" + std::to_string(lightIndex) + "].Pos").c_str());
-	glUniform3f(posLoc, m_position.x, m_position.y, m_position.z);
-	glCheckError();
-
-	GLint colorLoc = glGetUniformLocation(shader.Program, ("Lights[" + std::to_string(lightIndex) + "].Color").c_str());
-	glUniform3f(colorLoc, m_color.r, m_color.g, m_color.b);
-	glCheckError();
-
-	GLint typePos = glGetUniformLocation(shader.Program, ("Lights[" + std::to_string(lightIndex) + "].Type").c_str());
-	glUniform1i(typePos, GetType());
-	glCheckError();
-
-	GLint shadowModePos = glGetUniformLocation(shader.Program, ("Lights[" + std::to_string(lightIndex) + "].ShadowType").c_str());
-	glUniform1i(shadowModePos, m_shadowMode);
-	glCheckError();
+	for (int i = 0; i < LightData::MAX_CASCADES; ++i)
+		data.LightSpaceMatrices[i] = glm::mat4();
+	data.CascadeSplits = glm::vec4(0);
+	data.CascadeCount = 1;
+	data.Pos = m_position;
+	data.Type = GetType();
+	data.Color = m_color;
+	data.ShadowType = m_shadowMode;
+	data.IsEnabled = m_isEnabled;
+	data.CastShadow = m_castShadow && !m_shadowTiles.empty();
+	data.NearPlane = m_nearPlane;
+	data.FarPlane = m_farPlane;
+	data.ShadowProjection = 0;
+	for (int i = 0; i < LightData::MAX_SHADOW_TILES; ++i)
+		data.AtlasRects[i] = i < int(m_shadowTiles.size()) ? m_shadowTiles[i].GetRect(m_atlasSize) : glm::vec4(0);
+}
 
-	GLint enabledPos = glGetUniformLocation(shader.Program, ("Lights[" + std::to_string(lightIndex) + "].IsEnabled").c_str());
-	glUniform1i(enabledPos, m_isEnabled);
-	glCheckError();
+GLuint Light::GetShadowFaceCount() const
+{
+	return 1;
+}
 
-	GLint castChadowPos = glGetUniformLocation(shader.Program, ("Lights[" + std::to_string(lightIndex) + "].CastShadow").c_str());
-	glUniform1i(castChadowPos, m_castShadow);
-	glCheckError();
+void Light::FitToView(const glm::mat4&, const glm::mat4&, const RenderInfo&)
+{
+}
 
-	GLint nearPlaneLoc = glGetUniformLocation(shader.Program, ("Lights[" + std::to_string(lightIndex) + "].near_plane").c_str());
-	glUniform1f(nearPlaneLoc, m_nearPlane);
-	glCheckError();
+GLuint Light::GetStaleFaces() const
+{
+	return 0;
+}
 
-	GLint farPlaneLoc = glGetUniformLocation(shader.Program, ("Lights[" + std::to_string(lightIndex) + "].far_plane").c_str());
-	glUniform1f(farPlaneLoc, m_farPlane);
-	glCheckError();
+void Light::RenderShadowMap(GLuint faceMask, const ShadowAtlas& atlas, RenderQueue& queue, const std::vector<const BaseObject*>& casters) const
+{
+	PreRender(faceMask, atlas);
+	for (std::vector<const BaseObject*>::const_iterator it = casters.begin(); it != casters.end(); ++it)
+		(*it)->Submit(queue, ShadowPass, m_shadowShader);
+	queue.Flush();
+	glDisable(GL_CULL_FACE);
 }
 
-void Light::PostRender() const
+GLfloat Light::GetShadowImportance(const glm::mat4& view, const glm::mat4& projection) const
 {
-	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	// Screen coverage of the sphere the light reaches, as a share of the screen height squared
+	glm::vec3 viewPosition(view * glm::vec4(m_position, 1.0f));
+	GLfloat distanceSquared = glm::dot(viewPosition, viewPosition);
+	GLfloat radiusSquared = m_farPlane * m_farPlane;
+	if (distanceSquared <= radiusSquared)
+		return 1.0f;
+	if (viewPosition.z > m_farPlane)
+		return 0.0f;
+
+	GLfloat radius = m_farPlane * projection[1][1] / glm::sqrt(distanceSquared - radiusSquared);
+	return glm::min(radius * radius, 1.0f);
 }
 
 void Light::SetShadowMode(ShadowMode mode)
 {
 	m_shadowMode = mode;
-
-	switch (m_shadowMode)
-	{
-	case VsmShadows:
-		glBindTexture(textureType, shadowMap);
-
-		glTexParameteri(textureType, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-		glTexParameteri(textureType, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-
-		glBindTexture(textureType, 0);
-		break;
-	default:
-		glBindTexture(textureType, shadowMap);
-
-		glTexParameteri(textureType, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-		glTexParameteri(textureType, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-
-		glBindTexture(textureType, 0);
-		break;
-	}
 }
 
 ShadowMode Light::GetShadowMode() const
@@ -91,6 +89,17 @@ bool Light::CastsShadows() const
 	return m_castShadow;
 }
 
+void Light::SetShadowTiles(const std::vector<ShadowTile>& tiles, GLsizei atlasSize)
+{
+	m_shadowTiles = tiles;
+	m_atlasSize = atlasSize;
+}
+
+const std::vector<ShadowTile>& Light::GetShadowTiles() const
+{
+	return m_shadowTiles;
+}
+
 glm::vec3 Light::GetColor() const
 {
 	return m_color;
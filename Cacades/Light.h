@@ -1,6 +1,11 @@
 #pragma once
 #include "BaseObject.h"
 #include "Enums.h"
+#include "ShadowAtlas.h"
+#include <vector>
+
+struct LightData;
+struct RenderInfo;
 
 class Light : public BaseObject
 {
@@ -8,10 +13,19 @@ public:
 	Light(glm::vec3 position, glm::quat orientation, glm::vec3 color, Shader& shadowShader, int nearPlane, int farPlane);
 	virtual ~Light();
 
-	virtual void UpdateUniforms(const Shader& shader, int lightIndex, int textureIndex);
-
-	virtual void PreRender() const = 0;
-	virtual void PostRender() const;
+	virtual void WriteLightData(LightData& data);
+
+	// Clears the tiles selected by faceMask and sets up the shadow shader, the atlas has to be bound
+	virtual void PreRender(GLuint faceMask, const ShadowAtlas& atlas) const = 0;
+	virtual GLuint GetShadowFaceCount() const;
+	// Called every frame before shadows are scheduled, for maps that follow the camera
+	virtual void FitToView(const glm::mat4& view, const glm::mat4& projection, const RenderInfo& renderInfo);
+	// Faces whose shadow matrix changed since they were last rendered
+	virtual GLuint GetStaleFaces() const;
+	// Renders the casters into the tiles of the faces selected by faceMask
+	virtual void RenderShadowMap(GLuint faceMask, const ShadowAtlas& atlas, RenderQueue& queue, const std::vector<const BaseObject*>& casters) const;
+	// Share of the view the shadows of the light can affect, between 0 and 1
+	virtual GLfloat GetShadowImportance(const glm::mat4& view, const glm::mat4& projection) const;
 	virtual void RenderDebug(Shader& shader) const = 0;
 	
 	Shader& GetShadowShader() const
@@ -25,16 +39,16 @@ public:
 	void CastsShadows(bool value);
 	bool CastsShadows() const;
 
+	// One tile per face, empty when the atlas has no room for the light
+	void SetShadowTiles(const std::vector<ShadowTile>& tiles, GLsizei atlasSize);
+	const std::vector<ShadowTile>& GetShadowTiles() const;
+
 	virtual LightType GetType() = 0;
 	glm::vec3 GetColor() const;
 protected:
 	glm::vec3 m_color;
-	GLuint shadowMap;
-	GLuint shadowMapFBO;
-	GLuint textureType;
-	GLuint depthAttachment;
-	const GLuint SHADOW_RES = 4;
-	const GLuint SHADOW_WIDTH = 512 * SHADOW_RES, SHADOW_HEIGHT = 512 * SHADOW_RES;
+	std::vector<ShadowTile> m_shadowTiles;
+	GLsizei m_atlasSize;
 	Shader& m_shadowShader;
 	ShadowMode m_shadowMode;
 	GLfloat m_farPlane;
@@ -43,4 +57,3 @@ protected:
 
 	BaseObject* m_debugCube;
 };
-
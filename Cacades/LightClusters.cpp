@@ -0,0 +1,59 @@
+#include "LightClusters.h"
+#include "FrameUniforms.h"
+#include "Global.h"
+#include "Shader.h"
+
+// Depth range of a perspective projection
+static void GetDepthRange(const glm::mat4& projection, GLfloat& nearPlane, GLfloat& farPlane)
+{
+	nearPlane = projection[3][2] / (projection[2][2] - 1.0f);
+	farPlane = projection[3][2] / (projection[2][2] + 1.0f);
+}
+
+LightClusters::LightClusters()
+{
+	m_assignShader = new Shader("./shaders/ClusterLights.comp");
+	m_assignShader->Test("ClusterLights");
+
+	glGenBuffers(1, &m_clusterBuffer);
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_clusterBuffer);
+	glBufferData(GL_SHADER_STORAGE_BUFFER, GRID_X * GRID_Y * GRID_Z * CLUSTER_STRIDE * sizeof(GLuint), nullptr, GL_DYNAMIC_COPY);
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, CLUSTER_DATA_BINDING, m_clusterBuffer);
+	glCheckError();
+}
+
+LightClusters::~LightClusters()
+{
+	glDeleteBuffers(1, &m_clusterBuffer);
+	delete m_assignShader;
+}
+
+void LightClusters::WriteFrameData(FrameData& frame, const glm::mat4& projection, GLuint screenWidth, GLuint screenHeight) const
+{
+	GLfloat nearPlane, farPlane;
+	GetDepthRange(projection, nearPlane, farPlane);
+
+	// Slices grow exponentially: slice = GRID_Z * log(z / near) / log(far / near)
+	GLfloat logRange = glm::log(farPlane / nearPlane);
+	frame.ClusterScale = GRID_Z / logRange;
+	frame.ClusterBias = GRID_Z * glm::log(nearPlane) / logRange;
+	frame.ClusterTileSize = glm::vec2(GLfloat(screenWidth) / GRID_X, GLfloat(screenHeight) / GRID_Y);
+}
+
+void LightClusters::Assign(const glm::mat4& projection)
+{
+	GLfloat nearPlane, farPlane;
+	GetDepthRange(projection, nearPlane, farPlane);
+
+	m_assignShader->Use();
+	m_assignShader->SetMat4("inverseProjection", glm::inverse(projection));
+	m_assignShader->SetFloat("cameraNear", nearPlane);
+	m_assignShader->SetFloat("cameraFar", farPlane);
+
+	// The buffer binding is shared with the scene shaders, so it is only bound once in the constructor
+	glDispatchCompute(1, 1, GRID_Z);
+	glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+	glUseProgram(0);
+	glCheckError();
+}
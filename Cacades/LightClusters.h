@@ -0,0 +1,29 @@
+#pragma once
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+class Shader;
+struct FrameData;
+
+// Clustered forward lighting. Every frame a compute pass sorts the lights of the LightData buffer
+// into a froxel grid, so fragments only shade the lights that can reach them instead of all lights.
+class LightClusters
+{
+public:
+	LightClusters();
+	~LightClusters();
+
+	// Fills the cluster fields of the frame data for the camera projection and screen size
+	void WriteFrameData(FrameData& frame, const glm::mat4& projection, GLuint screenWidth, GLuint screenHeight) const;
+	// Assigns the lights to the clusters, the frame and light data have to be uploaded already
+	void Assign(const glm::mat4& projection);
+
+	// Has to match shaders/Clusters.glh
+	static const GLuint GRID_X = 16, GRID_Y = 9, GRID_Z = 24;
+	static const GLuint CLUSTER_STRIDE = 64;
+	static const GLuint CLUSTER_DATA_BINDING = 5;
+
+protected:
+	Shader* m_assignShader;
+	GLuint m_clusterBuffer;
+};
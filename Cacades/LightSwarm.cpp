@@ -0,0 +1,76 @@
+#include "LightSwarm.h"
+#include "PointLight.h"
+#include <glm/gtc/constants.hpp>
+#include <random>
+
+LightSwarm::LightSwarm(Shader& shadowShader, int count, GLfloat range, int seed) : m_time(0.0f), m_seed(seed), m_isEnabled(false)
+{
+	std::default_random_engine random(seed);
+	std::uniform_real_distribution<GLfloat> unit(0.0f, 1.0f);
+
+	for (int i = 0; i < count; ++i)
+	{
+		// Mostly lava glow, every fourth one a crystal
+		glm::vec3 color = i % 4 == 3
+			? glm::vec3(0.1f, 0.4f + 0.3f * unit(random), 0.8f)
+			: glm::vec3(0.8f, 0.2f + 0.3f * unit(random), 0.05f);
+
+		PointLight* light = new PointLight(glm::vec3(0), color, shadowShader, range);
+		light->CastsShadows(false);
+		light->IsEnabled(false);
+		m_lights.push_back(light);
+	}
+	m_wisps.resize(count);
+}
+
+LightSwarm::~LightSwarm()
+{
+	for (std::vector<PointLight*>::iterator it = m_lights.begin(); it != m_lights.end(); ++it)
+		delete *it;
+}
+
+void LightSwarm::Spawn(const glm::vec3& boundsMin, const glm::vec3& boundsMax)
+{
+	std::default_random_engine random(m_seed);
+	std::uniform_real_distribution<GLfloat> unit(0.0f, 1.0f);
+
+	glm::vec3 size = boundsMax - boundsMin;
+	for (std::vector<Wisp>::iterator it = m_wisps.begin(); it != m_wisps.end(); ++it)
+	{
+		it->Center = boundsMin + size * glm::vec3(unit(random), unit(random), unit(random));
+		it->Amplitude = size * 0.05f * glm::vec3(unit(random), unit(random), unit(random));
+		it->Frequency = glm::vec3(0.2f) + 0.6f * glm::vec3(unit(random), unit(random), unit(random));
+		it->Phase = glm::two_pi<GLfloat>() * unit(random);
+	}
+	Update(0.0f);
+}
+
+void LightSwarm::Update(GLfloat deltaTime)
+{
+	if (!m_isEnabled)
+		return;
+
+	m_time += deltaTime;
+	for (size_t i = 0; i < m_lights.size(); ++i)
+	{
+		const Wisp& wisp = m_wisps[i];
+		m_lights[i]->SetPosition(wisp.Center + wisp.Amplitude * glm::sin(wisp.Frequency * m_time + wisp.Phase));
+	}
+}
+
+void LightSwarm::IsEnabled(bool isEnabled)
+{
+	m_isEnabled = isEnabled;
+	for (std::vector<PointLight*>::iterator it = m_lights.begin(); it != m_lights.end(); ++it)
+		(*it)->IsEnabled(isEnabled);
+}
+
+bool LightSwarm::IsEnabled() const
+{
+	return m_isEnabled;
+}
+
+const std::vector<PointLight*>& LightSwarm::GetLights() const
+{
+	return m_lights;
+}
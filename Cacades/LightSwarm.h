@@ -0,0 +1,42 @@
+#pragma once
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+#include <vector>
+
+class Light;
+class PointLight;
+class Shader;
+
+// Small point lights drifting through the shaft, glowing like lava or crystals.
+// They cast no shadows and mainly exist to stress the clustered lighting with hundreds of lights.
+class LightSwarm
+{
+public:
+	LightSwarm(Shader& shadowShader, int count, GLfloat range, int seed);
+	~LightSwarm();
+
+	// Scatters the lights inside the box
+	void Spawn(const glm::vec3& boundsMin, const glm::vec3& boundsMax);
+	void Update(GLfloat deltaTime);
+
+	void IsEnabled(bool isEnabled);
+	bool IsEnabled() const;
+
+	const std::vector<PointLight*>& GetLights() const;
+
+protected:
+	// Every light wobbles around its center on a Lissajous curve
+	struct Wisp
+	{
+		glm::vec3 Center;
+		glm::vec3 Amplitude;
+		glm::vec3 Frequency;
+		GLfloat Phase;
+	};
+
+	std::vector<PointLight*> m_lights;
+	std::vector<Wisp> m_wisps;
+	GLfloat m_time;
+	int m_seed;
+	bool m_isEnabled;
+};
@@ -50,20 +50,16 @@ void MeasuringTool::Render(Shader& shader) const
 		m_hits[1].GetPosition()
 	};
 
-	GLint modelLoc = glGetUniformLocation(shader.Program, "model");
-	glUniformMatrix4fv(modelLoc, 1, GL_FALSE, glm::value_ptr(glm::mat4(1)));
+	shader.SetMat4("model", glm::mat4(1));
 	glCheckError();
 
-	GLint colorModeLoc = glGetUniformLocation(shader.Program, "colorMode");
-	glUniform1i(colorModeLoc, ColorOnly);
+	shader.SetInt("colorMode", ColorOnly);
 	glCheckError();
 
-	GLint objectColorLoc = glGetUniformLocation(shader.Program, "objectColor");
-	glUniform3fv(objectColorLoc, 1, glm::value_ptr(glm::vec3(1,0,0)));
+	shader.SetVec3("objectColor", glm::vec3(1,0,0));
 	glCheckError();
 
-	GLint normalModeLoc = glGetUniformLocation(shader.Program, "normalMode");
-	glUniform1i(normalModeLoc, NoNormals);
+	shader.SetInt("normalMode", NoNormals);
 	glCheckError();
 
 	glBindVertexArray(vao_);
@@ -0,0 +1,301 @@
+#include "MeshExporter.h"
+#include <glm/gtc/type_ptr.hpp>
+#include <glm/common.hpp>
+#include <cfloat>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include "Global.h"
+#include "Timer.h"
+#include "TriplanarMesh.h"
+
+bool MeshExporter::Export(const TriplanarMesh& mesh, const std::string& path, MeshFormat format, ExportStatistics* statistics)
+{
+	if (GetTotalTriCount(mesh) == 0)
+	{
+		std::cout << "ERROR::EXPORT::MESH_IS_EMPTY" << std::endl;
+		return false;
+	}
+
+	auto startTime = timerClock::now();
+
+	size_t bytes = 0;
+	switch (format)
+	{
+	case PlyFormat:
+		bytes = ExportPly(mesh, path);
+		break;
+	case GltfFormat:
+		bytes = ExportGltf(mesh, path);
+		break;
+	case RawFormat:
+		bytes = ExportRaw(mesh, path);
+		break;
+	}
+
+	auto endTime = timerClock::now();
+	if (bytes == 0)
+	{
+		std::cout << "ERROR::EXPORT::FAILED_TO_WRITE " << path << std::endl;
+		return false;
+	}
+
+	double milliseconds = cr::duration_cast<cr::microseconds>(endTime - startTime).count() / 1000.0;
+	double megabytes = bytes / (1024.0 * 1024.0);
+	double throughput = milliseconds > 0 ? megabytes / (milliseconds / 1000.0) : 0;
+
+	std::cout << "INFO::EXPORT " << path << ": " << megabytes << " MB in " << milliseconds << " ms (" << throughput << " MB/s)" << std::endl;
+
+	if (statistics)
+	{
+		statistics->Bytes = bytes;
+		statistics->Milliseconds = milliseconds;
+		statistics->MegabytesPerSecond = throughput;
+	}
+	return true;
+}
+
+const char* MeshExporter::GetExtension(MeshFormat format)
+{
+	switch (format)
+	{
+	case PlyFormat:
+		return ".ply";
+	case GltfFormat:
+		return ".gltf";
+	case RawFormat:
+		return ".raw";
+	}
+	return "";
+}
+
+size_t MeshExporter::ExportPly(const TriplanarMesh& mesh, const std::string& path)
+{
+	std::ofstream file(path, std::ios::binary);
+	if (!file)
+		return 0;
+
+	size_t triCount = GetTotalTriCount(mesh);
+	// PLY has no transform, so the vertices are written as they are rendered
+	glm::mat4 model = mesh.GetMatrix();
+
+	file << "ply\n"
+		<< "format binary_little_endian 1.0\n"
+		<< "comment generated by Cascades\n"
+		<< "element vertex " << triCount * 3 << "\n"
+		<< "property float x\nproperty float y\nproperty float z\n"
+		<< "property float nx\nproperty float ny\nproperty float nz\n"
+		<< "property float u\nproperty float v\nproperty float w\n"
+		<< "element face " << triCount << "\n"
+		<< "property list uchar uint vertex_indices\n"
+		<< "end_header\n";
+	size_t bytes = size_t(file.tellp());
+
+	bytes += StreamSlabs(mesh, file, nullptr, nullptr, &model);
+
+	// The marching cubes output is an unindexed triangle list, so the faces are simply consecutive
+	const size_t FACE_SIZE = sizeof(uint8_t) + 3 * sizeof(uint32_t);
+	const size_t FACES_PER_CHUNK = 4096;
+	char chunk[FACES_PER_CHUNK * FACE_SIZE];
+
+	for (size_t face = 0; face < triCount; )
+	{
+		size_t faceCount = glm::min(FACES_PER_CHUNK, triCount - face);
+		char* it = chunk;
+		for (size_t i = 0; i < faceCount; ++i, ++face)
+		{
+			uint8_t cornerCount = 3;
+			uint32_t indices[3] = { uint32_t(face * 3), uint32_t(face * 3 + 1), uint32_t(face * 3 + 2) };
+			memcpy(it, &cornerCount, sizeof(cornerCount));
+			memcpy(it + sizeof(cornerCount), indices, sizeof(indices));
+			it += FACE_SIZE;
+		}
+		file.write(chunk, faceCount * FACE_SIZE);
+		bytes += faceCount * FACE_SIZE;
+	}
+
+	return file ? bytes : 0;
+}
+
+struct Bounds
+{
+	glm::vec3 Min[3];
+	glm::vec3 Max[3];
+};
+
+static void GatherBounds(const GLfloat* vertices, GLsizei triCount, void* userData)
+{
+	Bounds& bounds = *static_cast<Bounds*>(userData);
+	const glm::vec3* attributes = reinterpret_cast<const glm::vec3*>(vertices);
+	for (GLsizei i = 0; i < triCount * 3; ++i, attributes += 3)
+	{
+		for (int a = 0; a < 3; ++a)
+		{
+			bounds.Min[a] = glm::min(bounds.Min[a], attributes[a]);
+			bounds.Max[a] = glm::max(bounds.Max[a], attributes[a]);
+		}
+	}
+}
+
+static void WriteVec3(std::ostream& stream, glm::vec3 v)
+{
+	stream << "[" << v.x << "," << v.y << "," << v.z << "]";
+}
+
+size_t MeshExporter::ExportGltf(const TriplanarMesh& mesh, const std::string& path)
+{
+	std::string binaryPath = path.substr(0, path.find_last_of('.')) + ".bin";
+	std::string binaryName = binaryPath.substr(binaryPath.find_last_of("/\\") + 1);
+
+	std::ofstream binary(binaryPath, std::ios::binary);
+	std::ofstream json(path);
+	if (!binary || !json)
+		return 0;
+
+	Bounds bounds;
+	for (int a = 0; a < 3; ++a)
+	{
+		bounds.Min[a] = glm::vec3(FLT_MAX);
+		bounds.Max[a] = glm::vec3(-FLT_MAX);
+	}
+
+	size_t binaryLength = StreamSlabs(mesh, binary, GatherBounds, &bounds);
+	size_t vertexCount = binaryLength / VERTEX_SIZE;
+	if (!binary)
+		return 0;
+
+	// One interleaved buffer view, the attributes only differ in their offset
+	const char* attributeNames[3] = { "POSITION", "NORMAL", "_UVW" };
+	const float* matrix = glm::value_ptr(mesh.GetMatrix());
+
+	json.precision(9);
+	json << "{\n"
+		<< "  \"asset\": { \"version\": \"2.0\", \"generator\": \"Cascades\" },\n"
+		<< "  \"scene\": 0,\n"
+		<< "  \"scenes\": [ { \"nodes\": [ 0 ] } ],\n"
+		<< "  \"nodes\": [ { \"mesh\": 0, \"matrix\": [";
+	for (int i = 0; i < 16; ++i)
+		json << (i ? "," : "") << matrix[i];
+	json << "] } ],\n"
+		<< "  \"meshes\": [ { \"primitives\": [ { \"attributes\": { ";
+	for (int a = 0; a < 3; ++a)
+		json << (a ? ", " : "") << "\"" << attributeNames[a] << "\": " << a;
+	json << " }, \"mode\": 4 } ] } ],\n"
+		<< "  \"buffers\": [ { \"uri\": \"" << binaryName << "\", \"byteLength\": " << binaryLength << " } ],\n"
+		<< "  \"bufferViews\": [ { \"buffer\": 0, \"byteOffset\": 0, \"byteLength\": " << binaryLength << ", \"byteStride\": " << VERTEX_SIZE << ", \"target\": 34962 } ],\n"
+		<< "  \"accessors\": [\n";
+	for (int a = 0; a < 3; ++a)
+	{
+		json << "    { \"bufferView\": 0, \"byteOffset\": " << a * sizeof(glm::vec3)
+			<< ", \"componentType\": 5126, \"count\": " << vertexCount << ", \"type\": \"VEC3\", \"min\": ";
+		WriteVec3(json, bounds.Min[a]);
+		json << ", \"max\": ";
+		WriteVec3(json, bounds.Max[a]);
+		json << " }" << (a < 2 ? "," : "") << "\n";
+	}
+	json << "  ]\n"
+		<< "}\n";
+
+	if (!json)
+		return 0;
+	return binaryLength + size_t(json.tellp());
+}
+
+size_t MeshExporter::ExportRaw(const TriplanarMesh& mesh, const std::string& path)
+{
+	std::ofstream file(path, std::ios::binary);
+	if (!file)
+		return 0;
+
+	// Header: magic, version, vertex size, triangle count, model matrix
+	const char magic[4] = { 'C', 'S', 'C', 'D' };
+	uint32_t version = 1;
+	uint32_t vertexSize = uint32_t(VERTEX_SIZE);
+	uint64_t triCount = GetTotalTriCount(mesh);
+	glm::mat4 model = mesh.GetMatrix();
+
+	file.write(magic, sizeof(magic));
+	file.write(reinterpret_cast<const char*>(&version), sizeof(version));
+	file.write(reinterpret_cast<const char*>(&vertexSize), sizeof(vertexSize));
+	file.write(reinterpret_cast<const char*>(&triCount), sizeof(triCount));
+	file.write(reinterpret_cast<const char*>(glm::value_ptr(model)), sizeof(model));
+	size_t bytes = sizeof(magic) + sizeof(version) + sizeof(vertexSize) + sizeof(triCount) + sizeof(model);
+
+	bytes += StreamSlabs(mesh, file);
+
+	return file ? bytes : 0;
+}
+
+size_t MeshExporter::StreamSlabs(const TriplanarMesh& mesh, std::ofstream& file, SlabCallback callback, void* userData, const glm::mat4* transform)
+{
+	glm::mat3 normalMatrix = transform ? glm::transpose(glm::inverse(glm::mat3(*transform))) : glm::mat3();
+	// Transformed vertices go through a fixed chunk, whole triangles per chunk for the callback
+	const GLsizei TRIS_PER_CHUNK = 512;
+	glm::vec3 chunk[TRIS_PER_CHUNK * 9];
+
+	SlabDrawHeader header;
+	std::vector<DrawArraysIndirectCommand> commands;
+	mesh.ReadCommands(header, commands);
+
+	size_t bytes = 0;
+	for (GLuint slab = 0; slab < commands.size(); ++slab)
+	{
+		GLsizei triCount = commands[slab].count / 3;
+		if (triCount == 0)
+			continue;
+
+		// All slabs share one buffer, the command holds the first vertex of the slab
+		GLsizeiptr size = triCount * 3 * VERTEX_SIZE;
+		GLintptr offset = GLintptr(commands[slab].first) * VERTEX_SIZE;
+		glBindBuffer(GL_COPY_READ_BUFFER, mesh.GetVBO());
+		const GLfloat* vertices = static_cast<const GLfloat*>(glMapBufferRange(GL_COPY_READ_BUFFER, offset, size, GL_MAP_READ_BIT));
+		glCheckError();
+		if (!vertices)
+		{
+			std::cout << "ERROR::EXPORT::MAP_BUFFER_FAILED slab " << slab << std::endl;
+			glBindBuffer(GL_COPY_READ_BUFFER, 0);
+			file.setstate(std::ios::failbit);
+			return bytes;
+		}
+
+		if (transform)
+		{
+			const glm::vec3* attributes = reinterpret_cast<const glm::vec3*>(vertices);
+			for (GLsizei tri = 0; tri < triCount; tri += TRIS_PER_CHUNK)
+			{
+				GLsizei chunkTris = glm::min(TRIS_PER_CHUNK, triCount - tri);
+				for (GLsizei i = 0; i < chunkTris * 9; i += 3, attributes += 3)
+				{
+					chunk[i] = glm::vec3(*transform * glm::vec4(attributes[0], 1.0f));
+					chunk[i + 1] = attributes[1] != glm::vec3(0) ? glm::normalize(normalMatrix * attributes[1]) : attributes[1];
+					chunk[i + 2] = attributes[2];
+				}
+
+				file.write(reinterpret_cast<const char*>(chunk), chunkTris * 3 * VERTEX_SIZE);
+				if (callback)
+					callback(reinterpret_cast<const GLfloat*>(chunk), chunkTris, userData);
+			}
+		}
+		else
+		{
+			file.write(reinterpret_cast<const char*>(vertices), size);
+			if (callback)
+				callback(vertices, triCount, userData);
+		}
+
+		glUnmapBuffer(GL_COPY_READ_BUFFER);
+		glBindBuffer(GL_COPY_READ_BUFFER, 0);
+		glCheckError();
+
+		bytes += size;
+	}
+	return bytes;
+}
+
+size_t MeshExporter::GetTotalTriCount(const TriplanarMesh& mesh)
+{
+	SlabDrawHeader header;
+	std::vector<DrawArraysIndirectCommand> commands;
+	mesh.ReadCommands(header, commands);
+	return header.TriangleCount;
+}
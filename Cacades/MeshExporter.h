@@ -0,0 +1,38 @@
+#pragma once
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+#include <fstream>
+#include <string>
+#include "Enums.h"
+
+class TriplanarMesh;
+
+struct ExportStatistics
+{
+	size_t Bytes = 0;
+	double Milliseconds = 0;
+	double MegabytesPerSecond = 0;
+};
+
+// Streams the slab VBOs of a TriplanarMesh to disk by mapping them one at a time,
+// so no copy of the whole mesh ever exists in client memory.
+class MeshExporter
+{
+public:
+	static bool Export(const TriplanarMesh& mesh, const std::string& path, MeshFormat format, ExportStatistics* statistics = nullptr);
+	static const char* GetExtension(MeshFormat format);
+
+	// position, normal, uvw
+	static const size_t VERTEX_SIZE = 3 * sizeof(glm::vec3);
+
+protected:
+	typedef void(*SlabCallback)(const GLfloat* vertices, GLsizei triCount, void* userData);
+
+	static size_t ExportPly(const TriplanarMesh& mesh, const std::string& path);
+	static size_t ExportGltf(const TriplanarMesh& mesh, const std::string& path);
+	static size_t ExportRaw(const TriplanarMesh& mesh, const std::string& path);
+
+	// A transform is applied to the positions and normals while the slabs are written, through a small fixed chunk
+	static size_t StreamSlabs(const TriplanarMesh& mesh, std::ofstream& file, SlabCallback callback = nullptr, void* userData = nullptr, const glm::mat4* transform = nullptr);
+	static size_t GetTotalTriCount(const TriplanarMesh& mesh);
+};
@@ -30,6 +30,20 @@ Model::Model(glm::vec3 position, glm::quat orientaton, Triangle* tris, GLsizei t
 	glBindBuffer(GL_ARRAY_BUFFER, m_vbo);
 	glBufferData(GL_ARRAY_BUFFER, triCount * sizeof(Triangle), tris, GL_STATIC_DRAW);
 	Vertex::ConfigVertexArrayObject(m_vao);
+
+	m_material.Textures[0] = m_texture ? m_texture->GetId() : 0;
+	m_material.Textures[1] = m_normalMap ? m_normalMap->GetId() : 0;
+	m_material.Textures[2] = m_displacementMap ? m_displacementMap->GetId() : 0;
+
+	m_boundsMin = m_boundsMax = triCount > 0 ? tris[0].GetVertex(0).Position : glm::vec3(0);
+	for (int i = 0; i < triCount; ++i)
+	{
+		for (int v = 0; v < 3; ++v)
+		{
+			m_boundsMin = glm::min(m_boundsMin, tris[i].GetVertex(v).Position);
+			m_boundsMax = glm::max(m_boundsMax, tris[i].GetVertex(v).Position);
+		}
+	}
 }
 
 Model::~Model()
@@ -48,50 +62,42 @@ void Model::Render(Shader& shader) const
 	if (!IsVisible())
 		return;
 
-	GLint modelLoc = glGetUniformLocation(shader.Program, "model");
-	glUniformMatrix4fv(modelLoc, 1, GL_FALSE, glm::value_ptr(GetMatrix()));
+	shader.SetMat4("model", GetMatrix());
 	glCheckError();
 
-	GLint colorModeLoc = glGetUniformLocation(shader.Program, "colorMode");
-	glUniform1i(colorModeLoc, m_colorMode);
+	shader.SetInt("colorMode", m_colorMode);
 	glCheckError();
 
-	GLint objectColorLoc = glGetUniformLocation(shader.Program, "objectColor");
-	glUniform3fv(objectColorLoc, 1, glm::value_ptr(m_color));
+	shader.SetVec3("objectColor", m_color);
 	glCheckError();
 
-	int textureLoc = glGetUniformLocation(shader.Program, "objectTexture");
 	if (m_texture != nullptr)
 	{
 		glActiveTexture(GL_TEXTURE1);
 		glBindTexture(GL_TEXTURE_2D, m_texture->GetId());
-		glUniform1i(textureLoc, 1);
+		shader.SetInt("objectTexture", 1);
 		glCheckError();
 	}
 
-	GLint normalModeLoc = glGetUniformLocation(shader.Program, "normalMode");
-	glUniform1i(normalModeLoc, m_normalMode);
+	shader.SetInt("normalMode", m_normalMode);
 	glCheckError();
 
-	GLint normalLoc = glGetUniformLocation(shader.Program, "normalMap");
 	if (m_normalMap != nullptr)
 	{
 		glActiveTexture(GL_TEXTURE2);
 		glBindTexture(GL_TEXTURE_2D, m_normalMap->GetId());
-		glUniform1i(normalLoc, 2);
+		shader.SetInt("normalMap", 2);
 		glCheckError();
 	}
 
-	GLint displacementModeLoc = glGetUniformLocation(shader.Program, "displacementMode");
-	glUniform1i(displacementModeLoc, m_displacementMode);
+	shader.SetInt("displacementMode", m_displacementMode);
 	glCheckError();
 
-	GLint displacementLoc = glGetUniformLocation(shader.Program, "displacementMap");
 	if (m_displacementMap != nullptr)
 	{
 		glActiveTexture(GL_TEXTURE3);
 		glBindTexture(GL_TEXTURE_2D, m_displacementMap->GetId());
-		glUniform1i(displacementLoc, 3);
+		shader.SetInt("displacementMap", 3);
 		glCheckError();
 	}
 
@@ -103,9 +109,49 @@ void Model::Render(Shader& shader) const
 
 	glBindVertexArray(0);
 
-	glUniform1i(textureLoc, 0);
+	shader.SetInt("objectTexture", 0);
+	glCheckError();
+	shader.SetInt("normalMap", 0);
+	glCheckError();
+}
+
+void Model::Submit(RenderQueue& queue, RenderPass pass, Shader& shader) const
+{
+	if (!IsVisible())
+		return;
+
+	DrawPacket packet;
+	packet.Program = &shader;
+	packet.Surface = pass == OpaquePass ? &m_material : nullptr;
+	packet.Object = this;
+	packet.Vao = m_vao;
+	packet.Count = m_triCount * 3;
+	packet.Position = m_position;
+	packet.HasBounds = true;
+	Frustum::TransformBounds(GetMatrix(), m_boundsMin, m_boundsMax, packet.BoundsMin, packet.BoundsMax);
+	queue.Submit(pass, packet);
+}
+
+void Model::SetDrawUniforms(const Shader& shader) const
+{
+	shader.SetMat4("model", GetMatrix());
+	glCheckError();
+
+	shader.SetInt("colorMode", m_colorMode);
+	glCheckError();
+
+	shader.SetVec3("objectColor", m_color);
+	glCheckError();
+
+	shader.SetInt("normalMode", m_normalMode);
 	glCheckError();
-	glUniform1i(normalLoc, 0);
+
+	shader.SetInt("displacementMode", m_displacementMode);
+	glCheckError();
+
+	shader.SetInt("objectTexture", Material::FIRST_UNIT);
+	shader.SetInt("normalMap", Material::FIRST_UNIT + 1);
+	shader.SetInt("displacementMap", Material::FIRST_UNIT + 2);
 	glCheckError();
 }
 
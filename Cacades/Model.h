@@ -19,6 +19,8 @@ public:
 
 	void Update(GLfloat deltaTime) override;
 	void Render(Shader& shader) const override;
+	void Submit(RenderQueue& queue, RenderPass pass, Shader& shader) const override;
+	void SetDrawUniforms(const Shader& shader) const override;
 
 	void GetKdPrimitives(std::vector<KdPrimitive*>& primitives) const;
 
@@ -43,5 +45,9 @@ protected:
 	Texture* m_texture;
 	Texture* m_normalMap;
 	Texture* m_displacementMap;
+	Material m_material;
+	// Object space bounds of m_tris
+	glm::vec3 m_boundsMin;
+	glm::vec3 m_boundsMax;
 };
 
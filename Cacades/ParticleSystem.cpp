@@ -120,20 +120,17 @@ void ParticleSystem::Update(GLfloat deltaTime, const UpdateInfo& info)
 
 void ParticleSystem::UpdateUniformsU(GLfloat deltaTime, const UpdateInfo& info)
 {
-	GLint deltaTimeLoc = glGetUniformLocation(m_updateShader->Program, "deltaTime");
-	glUniform1f(deltaTimeLoc, deltaTime);
+	m_updateShader->SetFloat("deltaTime", deltaTime);
 	glCheckError();
 
-	int densityLoc = glGetUniformLocation(m_updateShader->Program, "densityTex");
 	glActiveTexture(GL_TEXTURE1);
 	glBindTexture(GL_TEXTURE_3D, m_densityTex.GetId());
-	glUniform1i(densityLoc, 1);
+	m_updateShader->SetInt("densityTex", 1);
 	glCheckError();
 
-	int normalLoc = glGetUniformLocation(m_updateShader->Program, "normalTex");
 	glActiveTexture(GL_TEXTURE2);
 	glBindTexture(GL_TEXTURE_3D, m_normalTex.GetId());
-	glUniform1i(normalLoc, 2);
+	m_updateShader->SetInt("normalTex", 2);
 	glCheckError();
 }
 
@@ -153,28 +150,23 @@ void ParticleSystem::Render(const RenderInfo& info)
 
 void ParticleSystem::UpdateUniformsR(const RenderInfo& info)
 {
-	GLint resolutionLoc = glGetUniformLocation(m_renderShader->Program, "resolution");
-	glUniform3fv(resolutionLoc, 1, glm::value_ptr(m_resolution));
+	m_renderShader->SetVec3("resolution", m_resolution);
 	glCheckError();
 
-	int normalLoc = glGetUniformLocation(m_renderShader->Program, "normalTex");
 	glActiveTexture(GL_TEXTURE2);
 	glBindTexture(GL_TEXTURE_3D, m_normalTex.GetId());
-	glUniform1i(normalLoc, 2);
+	m_renderShader->SetInt("normalTex", 2);
 	glCheckError();
 
-	GLint modelLoc = glGetUniformLocation(m_renderShader->Program, "model");
-	glUniformMatrix4fv(modelLoc, 1, GL_FALSE, glm::value_ptr(GetMatrix()));
+	m_renderShader->SetMat4("model", GetMatrix());
 	glCheckError();
 
 	glm::mat4 view = m_camera.GetViewMatrix();
-	GLuint viewLocation = glGetUniformLocation(m_renderShader->Program, "view");
-	glUniformMatrix4fv(viewLocation, 1, GL_FALSE, glm::value_ptr(view));
+	m_renderShader->SetMat4("view", view);
 	glCheckError();
 
 	glm::mat4 proj = m_camera.GetProjectionMatrix();
-	GLuint projLocation = glGetUniformLocation(m_renderShader->Program, "projection");
-	glUniformMatrix4fv(projLocation, 1, GL_FALSE, glm::value_ptr(proj));
+	m_renderShader->SetMat4("projection", proj);
 	glCheckError();
 }
 
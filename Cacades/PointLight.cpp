@@ -5,93 +5,187 @@
 #include <string>
 #include "Global.h"
 #include "Box.h"
+#include "FrameUniforms.h"
 
-PointLight::PointLight(glm::vec3 position, glm::vec3 color, Shader& shadowShader, GLfloat farPlane, GLfloat nearPlane) : Light(position, glm::quat(), color, shadowShader, nearPlane, farPlane)
-{
-	glGenFramebuffers(1, &shadowMapFBO);
-	glBindFramebuffer(GL_FRAMEBUFFER, shadowMapFBO);
+// Distance past the seam, relative to the light distance, each paraboloid half still covers
+static const GLfloat PARABOLOID_OVERLAP = 0.05f;
 
-	textureType = GL_TEXTURE_CUBE_MAP;
+Shader* PointLight::s_faceShader = nullptr;
+Shader* PointLight::s_paraboloidShader = nullptr;
+int PointLight::s_instanceCount = 0;
 
-	glGenTextures(1, &shadowMap);
-	glBindTexture(textureType, shadowMap);
-	for (GLuint i = 0; i < 6; ++i)
-		glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, 0, GL_RG32F, SHADOW_WIDTH, SHADOW_HEIGHT, 0, GL_RG, GL_FLOAT, nullptr);
+PointLight::PointLight(glm::vec3 position, glm::vec3 color, Shader& shadowShader, GLfloat farPlane, GLfloat nearPlane) : Light(position, glm::quat(), color, shadowShader, nearPlane, farPlane),
+m_pointShadowMode(FaceCulledShadows)
+{
+	if (s_instanceCount++ == 0)
+	{
+		s_faceShader = new Shader("./shaders/PointLightFace.vert", nullptr, "./shaders/PointLight.frag");
+		s_paraboloidShader = new Shader("./shaders/PointLightParaboloid.vert", nullptr, "./shaders/PointLight.frag");
+	}
 
-	glTexParameteri(textureType, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-	glTexParameteri(textureType, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-	glTexParameteri(textureType, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-	glTexParameteri(textureType, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-	glTexParameteri(textureType, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
-	glCheckError();
+	m_debugCube = new Model(m_position, glm::quat(), Box::GetTris(glm::vec3(.1f)), 12, m_color, NoNormals);
+}
 
-	glFramebufferTexture(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, shadowMap, 0);
-	glBindTexture(textureType, 0);
-	glCheckError();
+PointLight::~PointLight()
+{
+	if (--s_instanceCount == 0)
+	{
+		delete s_faceShader;
+		delete s_paraboloidShader;
+		s_faceShader = s_paraboloidShader = nullptr;
+	}
+}
 
-	glGenTextures(1, &depthAttachment);
-	glBindTexture(textureType, depthAttachment);
-	for (GLuint i = 0; i < 6; ++i)
-		glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, 0, GL_DEPTH_COMPONENT, SHADOW_WIDTH, SHADOW_HEIGHT, 0, GL_DEPTH_COMPONENT, GL_FLOAT, nullptr);
+void PointLight::WriteLightData(LightData& data)
+{
+	Light::WriteLightData(data);
+	data.ShadowProjection = m_pointShadowMode;
+}
 
-	glTexParameteri(textureType, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-	glTexParameteri(textureType, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-	glTexParameteri(textureType, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-	glTexParameteri(textureType, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-	glTexParameteri(textureType, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
-	glCheckError();
+void PointLight::PreRender(GLuint faceMask, const ShadowAtlas& atlas) const
+{
+	PrepareTiles(faceMask, atlas);
+
+	m_shadowShader.Use();
 
-	glFramebufferTexture(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, depthAttachment, 0);
-	glBindTexture(textureType, 0);
+	m_shadowShader.SetInt("faceMask", faceMask);
 	glCheckError();
 
-	glCheckFrameBuffer();
+	std::vector<glm::mat4> shadowMatrices = GetShadowMatrices();
+	for (GLuint i = 0; i < 6; ++i)
+	{
+		m_shadowShader.SetMat4(UniformId("shadowMatrices", i), shadowMatrices[i]);
+		glCheckError();
+	}
 
-	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	m_shadowShader.SetVec3("lightPos", m_position);
 	glCheckError();
 
-	m_debugCube = new Model(m_position, glm::quat(), Box::GetTris(glm::vec3(.1f)), 12, m_color, NoNormals);
+	m_shadowShader.SetFloat("far_plane", m_farPlane);
+	glCheckError();
 }
 
-PointLight::~PointLight()
+void PointLight::PrepareTiles(GLuint faceMask, const ShadowAtlas& atlas) const
 {
+	for (GLuint face = 0; face < m_shadowTiles.size(); ++face)
+	{
+		// Faces select their tile through gl_ViewportIndex
+		m_shadowTiles[face].SetViewport(face);
+		if (faceMask & (1u << face))
+			atlas.ClearTile(m_shadowTiles[face]);
+	}
+	glCheckError();
 }
 
-void PointLight::UpdateUniforms(const Shader& shader, int lightIndex, int textureIndex)
+void PointLight::RenderShadowMap(GLuint faceMask, const ShadowAtlas& atlas, RenderQueue& queue, const std::vector<const BaseObject*>& casters) const
 {
-	Light::UpdateUniforms(shader, lightIndex, textureIndex);
+	if (m_shadowTiles.size() < GetShadowFaceCount())
+		return;
 
-	glActiveTexture(GL_TEXTURE0 + textureIndex);
-	glBindTexture(textureType, shadowMap);
-	GLuint depthCubePos = glGetUniformLocation(shader.Program, ("Lights[" + std::to_string(lightIndex) + "].depthCube").c_str());
-	glUniform1i(depthCubePos, textureIndex);
-	glCheckError();
+	switch (m_pointShadowMode)
+	{
+	case FaceCulledShadows:
+		RenderCubeFaces(faceMask, atlas, queue, casters);
+		break;
+	case DualParaboloidShadows:
+		RenderParaboloids(faceMask, atlas, queue, casters);
+		break;
+	default:
+		Light::RenderShadowMap(faceMask, atlas, queue, casters);
+		break;
+	}
 }
 
-void PointLight::PreRender() const
+void PointLight::RenderCubeFaces(GLuint faceMask, const ShadowAtlas& atlas, RenderQueue& queue, const std::vector<const BaseObject*>& casters) const
 {
-	glViewport(0, 0, SHADOW_WIDTH, SHADOW_HEIGHT);
-	glBindFramebuffer(GL_FRAMEBUFFER, shadowMapFBO);
-	glClearColor(1.0f, 1.0f, 1.0f, 1.0f);
-	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+	PrepareTiles(faceMask, atlas);
 
-	m_shadowShader.Use();
+	s_faceShader->Use();
 
 	std::vector<glm::mat4> shadowMatrices = GetShadowMatrices();
+	Frustum frustums[6];
 	for (GLuint i = 0; i < 6; ++i)
 	{
-		GLint shadowMatrixLoc = glGetUniformLocation(m_shadowShader.Program, ("shadowMatrices[" + std::to_string(i) + "]").c_str());
-		glUniformMatrix4fv(shadowMatrixLoc, 1, GL_FALSE, glm::value_ptr(shadowMatrices[i]));
-		glCheckError();
+		frustums[i] = Frustum(shadowMatrices[i]);
+		s_faceShader->SetMat4(UniformId("shadowMatrices", i), shadowMatrices[i]);
 	}
 
-	GLint lightPosLoc = glGetUniformLocation(m_shadowShader.Program, "lightPos");
-	glUniform3f(lightPosLoc, m_position.x, m_position.y, m_position.z);
+	s_faceShader->SetVec3("lightPos", m_position);
+	s_faceShader->SetFloat("far_plane", m_farPlane);
 	glCheckError();
 
-	GLint farPlaneLoc = glGetUniformLocation(m_shadowShader.Program, "far_plane");
-	glUniform1f(farPlaneLoc, m_farPlane);
-	glCheckError();
+	if (GLEW_ARB_shader_viewport_layer_array)
+	{
+		// The vertex shader selects the viewport, one instance per face a caster touches
+		queue.SetLayerFrustums(frustums, faceMask, true);
+		for (std::vector<const BaseObject*>::const_iterator it = casters.begin(); it != casters.end(); ++it)
+			(*it)->Submit(queue, ShadowPass, *s_faceShader);
+		queue.Flush();
+	}
+	else
+	{
+		for (GLuint face = 0; face < 6; ++face)
+		{
+			if (!(faceMask & (1u << face)))
+				continue;
+
+			m_shadowTiles[face].SetViewport();
+
+			queue.SetLayerFrustums(frustums, 1u << face, false);
+			for (std::vector<const BaseObject*>::const_iterator it = casters.begin(); it != casters.end(); ++it)
+				(*it)->Submit(queue, ShadowPass, *s_faceShader);
+			queue.Flush();
+		}
+	}
+
+	queue.ClearLayerFrustums();
+	glDisable(GL_CULL_FACE);
+}
+
+void PointLight::RenderParaboloids(GLuint faceMask, const ShadowAtlas& atlas, RenderQueue& queue, const std::vector<const BaseObject*>& casters) const
+{
+	glEnable(GL_CLIP_DISTANCE0);
+
+	for (GLuint half = 0; half < 2; ++half)
+	{
+		if (!(faceMask & (1u << half)))
+			continue;
+
+		atlas.ClearTile(m_shadowTiles[half]);
+		m_shadowTiles[half].SetViewport();
+
+		GLfloat hemisphere = half == 0 ? 1.0f : -1.0f;
+		s_paraboloidShader->Use();
+		s_paraboloidShader->SetVec3("lightPos", m_position);
+		s_paraboloidShader->SetFloat("near_plane", m_nearPlane);
+		s_paraboloidShader->SetFloat("far_plane", m_farPlane);
+		s_paraboloidShader->SetFloat("hemisphere", hemisphere);
+		s_paraboloidShader->SetFloat("overlap", PARABOLOID_OVERLAP);
+		glCheckError();
+
+		// Half space in front of the light, widened by the overlap at the far plane
+		Frustum halfSpace;
+		halfSpace.AddPlane(glm::vec4(0, 0, -hemisphere, hemisphere * m_position.z + PARABOLOID_OVERLAP * m_farPlane));
+
+		queue.SetLayerFrustums(&halfSpace, 1, false);
+		for (std::vector<const BaseObject*>::const_iterator it = casters.begin(); it != casters.end(); ++it)
+			(*it)->Submit(queue, ShadowPass, *s_paraboloidShader);
+		queue.Flush();
+	}
+
+	queue.ClearLayerFrustums();
+	glDisable(GL_CLIP_DISTANCE0);
+	glDisable(GL_CULL_FACE);
+}
+
+void PointLight::SetPointShadowMode(PointShadowMode mode)
+{
+	m_pointShadowMode = mode;
+}
+
+PointShadowMode PointLight::GetPointShadowMode() const
+{
+	return m_pointShadowMode;
 }
 
 void PointLight::RenderDebug(Shader& shader) const
@@ -100,6 +194,11 @@ void PointLight::RenderDebug(Shader& shader) const
 	m_debugCube->Render(shader);
 }
 
+GLuint PointLight::GetShadowFaceCount() const
+{
+	return m_pointShadowMode == DualParaboloidShadows ? 2 : 6;
+}
+
 LightType PointLight::GetType()
 {
 	return LightType::Point;
@@ -120,6 +219,5 @@ std::vector<glm::mat4> PointLight::GetShadowMatrices() const
 
 glm::mat4 PointLight::GetProjection() const
 {
-	GLfloat aspect = (GLfloat)SHADOW_WIDTH / (GLfloat)SHADOW_HEIGHT;
-	return  glm::perspective(glm::radians(90.0f), aspect, m_nearPlane, m_farPlane);
+	return  glm::perspective(glm::radians(90.0f), 1.0f, m_nearPlane, m_farPlane);
 }
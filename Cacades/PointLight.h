@@ -11,14 +11,33 @@ public:
 	PointLight(glm::vec3 position, glm::vec3 color, Shader& shadowShader, GLfloat farPlane, GLfloat nearPlane = 0.1f);
 	virtual ~PointLight();
 
-	void UpdateUniforms(const Shader& shader, int lightIndex, int textureIndex) override;
+	void WriteLightData(LightData& data) override;
 
-	void PreRender() const override;
+	void PreRender(GLuint faceMask, const ShadowAtlas& atlas) const override;
+	// Faces are the six cube faces, or the two hemispheres of the dual paraboloid map
+	GLuint GetShadowFaceCount() const override;
+	void RenderShadowMap(GLuint faceMask, const ShadowAtlas& atlas, RenderQueue& queue, const std::vector<const BaseObject*>& casters) const override;
 	void RenderDebug(Shader& shader) const override;
+
+	void SetPointShadowMode(PointShadowMode mode);
+	PointShadowMode GetPointShadowMode() const;
 		
 protected:
 	LightType GetType() override;
 	glm::mat4 GetProjection() const;
 	std::vector<glm::mat4> GetShadowMatrices() const;
+
+	// Clears the tiles of the faces in faceMask and points the viewport array to the tiles
+	void PrepareTiles(GLuint faceMask, const ShadowAtlas& atlas) const;
+	void RenderCubeFaces(GLuint faceMask, const ShadowAtlas& atlas, RenderQueue& queue, const std::vector<const BaseObject*>& casters) const;
+	void RenderParaboloids(GLuint faceMask, const ShadowAtlas& atlas, RenderQueue& queue, const std::vector<const BaseObject*>& casters) const;
+
+	// The hemisphere facing -z uses the first tile, the one facing +z the second
+	PointShadowMode m_pointShadowMode;
+
+	// Shared by all point lights and freed with the last one, the geometry shader path uses m_shadowShader
+	static Shader* s_faceShader;
+	static Shader* s_paraboloidShader;
+	static int s_instanceCount;
 };
 
@@ -5,9 +5,10 @@
 #include <glm/gtc/type_ptr.hpp>
 #include "Shader.h"
 #include <string>
+#include <iostream>
 #include "BoundingBox.h"
 
-ProcedualGenerator::ProcedualGenerator() : m_noise(nullptr), m_random(0), m_randomAngle(0, 359), m_randomRand(-glm::pi<float>(), glm::pi<float>()), m_randomFloat(0.0f, 1000.0f)
+ProcedualGenerator::ProcedualGenerator() : m_noise(nullptr), m_generatedQuery(0), m_isGeneratedPending(false), m_densityField(WIDTH, DEPTH, LAYERS), m_seed(0), m_statisticsBuffer(0), m_collectStatistics(false), m_meshGeneration(0), m_random(0), m_randomAngle(0, 359), m_randomRand(-glm::pi<float>(), glm::pi<float>()), m_randomFloat(0.0f, 1000.0f)
 {
 	SetupDensity(); 
 	SetupMC();
@@ -32,7 +33,20 @@ void ProcedualGenerator::SetupMC()
 	glBindBuffer(GL_ARRAY_BUFFER, 0);
 	glBindVertexArray(0);
 
-	glGenBuffers(1, &m_tboMc);
+	m_slabCommandShader = new Shader("./shaders/SlabCommands.comp");
+	m_slabCommandShader->Test("SlabCommands");
+
+	m_slabBoundsShader = new Shader("./shaders/SlabBounds.comp");
+	m_slabBoundsShader->Test("SlabBounds");
+
+	glGenQueries(TriplanarMesh::SLAB_COUNT, m_slabQueries);
+	glGenQueries(1, &m_generatedQuery);
+	glCheckError();
+
+	glGenBuffers(1, &m_statisticsBuffer);
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_statisticsBuffer);
+	glBufferData(GL_SHADER_STORAGE_BUFFER, sizeof(m_statistics.CaseHistogram), nullptr, GL_DYNAMIC_READ);
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
 	glCheckError();
 }
 
@@ -44,6 +58,9 @@ void ProcedualGenerator::SetupDensity()
 	m_normalShader = new  Shader("./shaders/Normal.vert", "./shaders/Normal.geom", "./shaders/Normal.frag");
 	m_normalShader->Test("Normal");
 
+	m_densityFieldShader = new Shader("./shaders/DensityField.comp");
+	m_densityFieldShader->Test("DensityField");
+
 	glBindTexture(GL_TEXTURE_3D, m_densityTex.GetId());
 	glTexImage3D(GL_TEXTURE_3D, 0, GL_R16F, WIDTH, DEPTH, LAYERS, 0, GL_RED, GL_FLOAT, nullptr);
 	glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
@@ -116,11 +133,14 @@ ProcedualGenerator::~ProcedualGenerator()
 	glDeleteVertexArrays(1, &m_vaoD);
 	glDeleteBuffers(1, &m_vboD);
 	glDeleteFramebuffers(1, &m_fboD);
-	glDeleteBuffers(1, &m_tboMc);
+	glDeleteQueries(TriplanarMesh::SLAB_COUNT, m_slabQueries);
+	glDeleteQueries(1, &m_generatedQuery);
+	glDeleteBuffers(1, &m_statisticsBuffer);
 }
 
 void ProcedualGenerator::Generate3dTexture()
 {
+	m_stageTimer.Begin("density");
 	glBindFramebuffer(GL_FRAMEBUFFER, m_fboD);
 	glDrawBuffer(GL_COLOR_ATTACHMENT0);
 	glReadBuffer(GL_NONE);
@@ -141,7 +161,9 @@ void ProcedualGenerator::Generate3dTexture()
 	glUseProgram(0);
 	glBindFramebuffer(GL_FRAMEBUFFER, 0);
 	glCheckError();
+	m_stageTimer.End();
 
+	m_stageTimer.Begin("normal");
 	glBindFramebuffer(GL_FRAMEBUFFER, m_fboN);
 	glDrawBuffer(GL_COLOR_ATTACHMENT0);
 	glReadBuffer(GL_NONE);
@@ -163,6 +185,7 @@ void ProcedualGenerator::Generate3dTexture()
 	glBindFramebuffer(GL_FRAMEBUFFER, 0);
 	glViewport(0, 0, SCREEN_WIDTH, SCREEN_HEIGHT);
 	glCheckError();
+	m_stageTimer.End();
 }
 
 void ProcedualGenerator::GenerateMcVbo()
@@ -196,71 +219,138 @@ void ProcedualGenerator::GenerateMcVbo()
 
 	delete[] vertices;
 
-	glBindBuffer(GL_TRANSFORM_FEEDBACK_BUFFER, m_tboMc);
-		glBufferData(GL_TRANSFORM_FEEDBACK_BUFFER, (GetVertexCountTf() * 5 * (3 * sizeof(glm::vec3) * 3)) / m_mcMesh.GetVaoCount(), nullptr, GL_DYNAMIC_COPY);
-	glBindBuffer(GL_TRANSFORM_FEEDBACK_BUFFER, 0);
+	// Up to 5 triangles per cube, but surfaces only cross a small part of the volume. Transform feedback
+	// stops writing once the buffer is full, PollMeshOverflow notices that and grows the buffer.
+	m_mcMesh.Reserve(GLsizeiptr(GetVertexCountTf()) * 5 / MESH_CAPACITY_DIVISOR);
 	glCheckError();
 }
 
 TriplanarMesh* ProcedualGenerator::GenerateMesh()
 {
+	++m_meshGeneration;
+
+	// CPU copy of the field for collision queries, read back asynchronously
+	m_stageTimer.Begin("density_field");
+	m_densityFieldShader->Use();
+	UpdateUniformsNoise(*m_densityFieldShader);
+	m_densityField.Bake(*m_densityFieldShader);
+	m_stageTimer.End();
+
 	m_marchingCubeShader->Use();
 	UpdateUniformsMc();
 
-	// Create query object to collect info
-	GLuint queryTF;
-	glGenQueries(1, &queryTF);
+	if (m_collectStatistics)
+	{
+		GLuint zero = 0;
+		glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_statisticsBuffer);
+		glClearBufferData(GL_SHADER_STORAGE_BUFFER, GL_R32UI, GL_RED_INTEGER, GL_UNSIGNED_INT, &zero);
+		glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+		glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 3, m_statisticsBuffer);
+		glCheckError();
+	}
+	m_marchingCubeShader->SetInt("collectStatistics", m_collectStatistics);
+	glCheckError();
 
 	// Perform feedback transform
 	glEnable(GL_RASTERIZER_DISCARD);
 
-	int layerPerVao = m_cubesPerDimension.y / m_mcMesh.GetVaoCount();
-	GLuint sumTriCount = 0;
-	GLuint triCount;
+	int layerPerSlab = m_cubesPerDimension.y / m_mcMesh.GetSlabCount();
 
-	glBindBufferBase(GL_TRANSFORM_FEEDBACK_BUFFER, 0, m_tboMc);
-	for (int vao = 0; vao < m_mcMesh.GetVaoCount(); ++vao)
+	// All slabs are appended to the mesh buffer by one transform feedback pass. The triangle count of
+	// every slab goes straight from its query into the command buffer, the CPU never waits for it.
+	glBindBufferBase(GL_TRANSFORM_FEEDBACK_BUFFER, 0, m_mcMesh.GetVBO());
+	glBindBuffer(GL_QUERY_BUFFER, m_mcMesh.GetCommandBuffer());
+	glBindVertexArray(m_vaoMc);
+	// Counts the triangles that didn't fit as well, read back without waiting by PollMeshOverflow
+	glBeginQuery(GL_PRIMITIVES_GENERATED, m_generatedQuery);
+	glBeginTransformFeedback(GL_TRIANGLES);
+	for (int slab = 0; slab < m_mcMesh.GetSlabCount(); ++slab)
 	{
-		GLuint layerLocation = glGetUniformLocation(m_marchingCubeShader->Program, "layerStart");
-		glUniform1i(layerLocation, vao * layerPerVao);
+		m_marchingCubeShader->SetInt("layerStart", slab * layerPerSlab);
 		glCheckError();
 
-		glBindVertexArray(m_vaoMc);
-	
-		glBeginQuery(GL_TRANSFORM_FEEDBACK_PRIMITIVES_WRITTEN, queryTF);
-			glBeginTransformFeedback(GL_TRIANGLES);
-				glDrawArraysInstanced(GL_POINTS, 0, GetVertexCountMc(), layerPerVao);
-				//glDrawArrays(GL_POINTS, 0, m_generator.GetVertexCount());
-			glEndTransformFeedback();
+		m_stageTimer.Begin("marching_cubes[" + std::to_string(slab) + "]");
+		glBeginQuery(GL_TRANSFORM_FEEDBACK_PRIMITIVES_WRITTEN, m_slabQueries[slab]);
+			glDrawArraysInstanced(GL_POINTS, 0, GetVertexCountMc(), layerPerSlab);
 		glEndQuery(GL_TRANSFORM_FEEDBACK_PRIMITIVES_WRITTEN);
+		glGetQueryObjectuiv(m_slabQueries[slab], GL_QUERY_RESULT, (GLuint*)TriplanarMesh::GetCommandOffset(slab));
+		m_stageTimer.End();
 
-		glBindVertexArray(0);
-
-		// Fetch and print results
-		glGetQueryObjectuiv(queryTF, GL_QUERY_RESULT, &triCount);
-		sumTriCount += triCount;
-
-		glBindVertexArray(m_mcMesh.GetVAO(vao));
-			glBindBuffer(GL_ARRAY_BUFFER, m_mcMesh.GetVBO(vao));
-				glBufferData(GL_ARRAY_BUFFER, triCount * 3 * (sizeof(glm::vec3) * 3), nullptr, GL_STATIC_COPY);
-				glCheckError();
-				glCopyBufferSubData(GL_TRANSFORM_FEEDBACK_BUFFER, GL_ARRAY_BUFFER, 0, 0, triCount * 3 * (sizeof(glm::vec3) * 3));
-			glCheckError();
-			glBindBuffer(GL_ARRAY_BUFFER, 0);
-		glBindVertexArray(0);
-		m_mcMesh.UpdateVao(vao, triCount);
+		// Cubes of the slab, padded by one cell since triangles may reach into the neighbouring layer
+		glm::vec3 boundsMin(-1.0f - m_mcResolution.x, -1.0f + m_mcResolution.y * (slab * layerPerSlab - 1), -1.0f - m_mcResolution.z);
+		glm::vec3 boundsMax(1.0f + m_mcResolution.x, -1.0f + m_mcResolution.y * ((slab + 1) * layerPerSlab + 1), 1.0f + m_mcResolution.z);
+		m_mcMesh.SetSlabBounds(slab, boundsMin, boundsMax);
 	}
+	glEndTransformFeedback();
+	glEndQuery(GL_PRIMITIVES_GENERATED);
+	m_isGeneratedPending = true;
+	glBindVertexArray(0);
+	glBindBuffer(GL_QUERY_BUFFER, 0);
 	glBindBufferBase(GL_TRANSFORM_FEEDBACK_BUFFER, 0, 0);
 	glDisable(GL_RASTERIZER_DISCARD);
+	glCheckError();
+
+	m_stageTimer.Begin("slab_commands");
+	m_slabCommandShader->Use();
+	m_slabCommandShader->SetInt("slabCount", m_mcMesh.GetSlabCount());
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, m_mcMesh.GetCommandBuffer());
+	glDispatchCompute(1, 1, 1);
+	glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+
+	// Tight bounds of every slab for culling, the bounds derived from the layers span the whole volume
+	m_slabBoundsShader->Use();
+	m_slabBoundsShader->SetVec3("padding", m_mcResolution);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, m_mcMesh.GetVBO());
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, m_mcMesh.GetBoundsBuffer());
+	glDispatchCompute(m_mcMesh.GetSlabCount(), 1, 1);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, 0);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, 0);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, 0);
+	glMemoryBarrier(GL_COMMAND_BARRIER_BIT | GL_SHADER_STORAGE_BARRIER_BIT | GL_VERTEX_ATTRIB_ARRAY_BARRIER_BIT);
+	m_stageTimer.End();
+	glCheckError();
 
-	glFlush();
+	m_stageTimer.Begin("decorations");
+	GenerateDecorations();
+	m_stageTimer.End();
 
-	glDeleteQueries(1, &queryTF);
-	printf("%u primitives generated!\n\n", sumTriCount);
+	ReadStatistics();
 
 	return &m_mcMesh;
 }
 
+bool ProcedualGenerator::PollMeshOverflow()
+{
+	if (!m_isGeneratedPending)
+		return false;
+
+	GLint available = 0;
+	glGetQueryObjectiv(m_generatedQuery, GL_QUERY_RESULT_AVAILABLE, &available);
+	if (!available)
+		return false;
+
+	GLuint generated = 0;
+	glGetQueryObjectuiv(m_generatedQuery, GL_QUERY_RESULT, &generated);
+	m_isGeneratedPending = false;
+	glCheckError();
+
+	GLsizeiptr capacity = m_mcMesh.GetTriangleCapacity();
+	if (GLsizeiptr(generated) <= capacity)
+		return false;
+
+	// A quarter more, so a slightly denser seed doesn't overflow right away, but never beyond the worst case
+	GLsizeiptr grown = glm::min(GLsizeiptr(generated) + GLsizeiptr(generated) / 4, GLsizeiptr(GetVertexCountTf()) * 5);
+	std::cout << "ERROR::GENERATOR::MESH_TRUNCATED " << generated << " triangles generated, " << capacity << " fit, growing the buffer to " << grown << std::endl;
+	m_mcMesh.Reserve(grown);
+	GenerateMesh();
+	return true;
+}
+
+void ProcedualGenerator::GenerateDecorations()
+{
+	m_scatter.Scatter(m_mcMesh, m_seed);
+}
+
 GLuint ProcedualGenerator::GetVertexCountMc() const
 {
 	return m_vertexCount;
@@ -281,8 +371,29 @@ const Texture& ProcedualGenerator::GetNormalTexture() const
 	return m_normalTex;
 }
 
+SurfaceScatter& ProcedualGenerator::GetScatter()
+{
+	return m_scatter;
+}
+
+const GeneratorStatistics& ProcedualGenerator::GetStatistics() const
+{
+	return m_statistics;
+}
+
+DensityField& ProcedualGenerator::GetDensityField()
+{
+	return m_densityField;
+}
+
+GLuint ProcedualGenerator::GetMeshGeneration() const
+{
+	return m_meshGeneration;
+}
+
 void ProcedualGenerator::SetRandomSeed(int seed)
 {
+	m_seed = seed;
 	m_random.seed(seed);
 
 	m_pillars[0] = Randoms{ m_randomRand(m_random), ToSignBit(m_random()), m_randomFloat(m_random) };
@@ -295,6 +406,7 @@ void ProcedualGenerator::SetRandomSeed(int seed)
 	m_shelf = Randoms{ m_randomRand(m_random), ToSignBit(m_random()), m_randomFloat(m_random) };
 
 	//delete[] m_noise;
+	m_stageTimer.Begin("noise_textures");
 	m_noise = new Noise[4]
 	{
 		Noise(glm::toMat4(MakeQuat(m_randomAngle(m_random), m_randomAngle(m_random), m_randomAngle(m_random))), NoiseTexture(16, 16, 16, 1)),
@@ -302,6 +414,7 @@ void ProcedualGenerator::SetRandomSeed(int seed)
 		Noise(glm::toMat4(MakeQuat(m_randomAngle(m_random), m_randomAngle(m_random), m_randomAngle(m_random))), NoiseTexture(16, 16, 16, 3)),
 		Noise(glm::toMat4(MakeQuat(m_randomAngle(m_random), m_randomAngle(m_random), m_randomAngle(m_random))), NoiseTexture(16, 16, 16, 4))
 	};
+	m_stageTimer.End();
 }
 
 void ProcedualGenerator::SetStartLayer(int layer)
@@ -324,6 +437,7 @@ void ProcedualGenerator::SetGeometryScale(glm::vec3 scale)
 {
 	m_geometryScale = scale;
 	m_mcMesh.SetScale(scale);
+	m_densityField.SetScale(scale);
 }
 
 const glm::vec3 ProcedualGenerator::GetGeometryScale() const
@@ -334,125 +448,141 @@ const glm::vec3 ProcedualGenerator::GetGeometryScale() const
 void ProcedualGenerator::SetIsoLevel(float isoLevel)
 {
 	m_isoLevel = isoLevel;
+	m_densityField.SetIsoLevel(isoLevel);
+}
+
+void ProcedualGenerator::SetCollectStatistics(bool collectStatistics)
+{
+	m_collectStatistics = collectStatistics;
 }
 
 void ProcedualGenerator::UpdateUniformsMc()
 {
 	m_lookupTable.UpdateUniforms(*m_marchingCubeShader);
 
-	GLint resolutioneLoc = glGetUniformLocation(m_marchingCubeShader->Program, "resolution");
-	glUniform3fv(resolutioneLoc, 1, glm::value_ptr(m_mcResolution));
+	UpdateUniformsNoise(*m_marchingCubeShader);
+
+	m_marchingCubeShader->SetVec3("textureRepeat", glm::vec3(WIDTH / 8, LAYERS / 8, DEPTH / 8));
+	glCheckError();
+
+	m_marchingCubeShader->SetInt("isoLevel", m_isoLevel);
+	glCheckError();
+
+	m_marchingCubeShader->SetVec3("scale", m_geometryScale);
 	glCheckError();
+}
 
-	GLuint layerLocation = glGetUniformLocation(m_marchingCubeShader->Program, "layerCorrection");
-	glUniform1i(layerLocation, m_layerCorrection * m_cubesPerDimension.y / LAYERS);
+void ProcedualGenerator::UpdateUniformsNoise(const Shader& shader)
+{
+	shader.SetVec3("resolution", m_mcResolution);
 	glCheckError();
 
-	GLuint noiseScaleLocation = glGetUniformLocation(m_marchingCubeShader->Program, "noiseScale");
-	glUniform1f(noiseScaleLocation, m_noiseScale);
+	shader.SetInt("layerCorrection", m_layerCorrection * m_cubesPerDimension.y / LAYERS);
 	glCheckError();
 
-	GLuint textureRepeatLocation = glGetUniformLocation(m_marchingCubeShader->Program, "textureRepeat");
-	glUniform3fv(textureRepeatLocation, 1, glm::value_ptr(glm::vec3(WIDTH / 8, LAYERS / 8, DEPTH / 8)));
+	shader.SetFloat("noiseScale", m_noiseScale);
 	glCheckError();
 
 	for (int i = 0; i < 4; ++i)
 	{
 		glActiveTexture(GL_TEXTURE0 + i);
 		GLuint textureId = m_noise[i].texture.GetId();
-		GLint textureLoc = glGetUniformLocation(m_marchingCubeShader->Program, ("noise[" + std::to_string(i) + "].tex").c_str());
-		glUniform1i(textureLoc, i);
+		shader.SetInt(UniformId("noise", i, ".tex"), i);
 		glBindTexture(GL_TEXTURE_3D, textureId);
 		glCheckError();
 
 		glm::mat4 rot = m_noise[i].rotation;
-		GLuint rotLocation = glGetUniformLocation(m_marchingCubeShader->Program, ("noise[" + std::to_string(i) + "].rotation").c_str());
-		glUniformMatrix4fv(rotLocation, 1, GL_FALSE, glm::value_ptr(rot));
+		shader.SetMat4(UniformId("noise", i, ".rotation"), rot);
 		glCheckError();
 	}
 
 	glActiveTexture(GL_TEXTURE4);
-	GLint textureLoc = glGetUniformLocation(m_marchingCubeShader->Program, "densityTex");
-	glUniform1i(textureLoc, 4);
+	shader.SetInt("densityTex", 4);
 	glBindTexture(GL_TEXTURE_3D, m_densityTex.GetId());
 	glCheckError();
-
-	GLint isoLevelLoc = glGetUniformLocation(m_marchingCubeShader->Program, "isoLevel");
-	glUniform1i(isoLevelLoc, m_isoLevel);
-	glCheckError();
-
-	GLuint scaleLocation = glGetUniformLocation(m_marchingCubeShader->Program, "scale");
-	glUniform3fv(scaleLocation, 1, glm::value_ptr(m_geometryScale));
-	glCheckError();
 }
 
 void ProcedualGenerator::UpdateUniformsD()
 {
-	GLuint resLocation = glGetUniformLocation(m_densityShader->Program, "resolution");
-	glUniform3f(resLocation, WIDTH, LAYERS, DEPTH);
+	m_densityShader->SetVec3("resolution", glm::vec3(WIDTH, LAYERS, DEPTH));
 	glCheckError();
 
-	GLuint layerLocation = glGetUniformLocation(m_densityShader->Program, "startLayer");
-	glUniform1i(layerLocation, m_layerCorrection);
+	m_densityShader->SetInt("startLayer", m_layerCorrection);
 	glCheckError();
 
 	for (int i = 0; i < 4; ++i)
 	{
-		GLuint posLocation = glGetUniformLocation(m_densityShader->Program, ("pillars[" + std::to_string(i) + "].offset").c_str());
-		glUniform1f(posLocation, m_pillars[i].offset);
+		m_densityShader->SetFloat(UniformId("pillars", i, ".offset"), m_pillars[i].offset);
 		glCheckError();
 
-		GLuint freqLocation = glGetUniformLocation(m_densityShader->Program, ("pillars[" + std::to_string(i) + "].frequence").c_str());
-		glUniform1f(freqLocation, m_pillars[i].frequence);
+		m_densityShader->SetFloat(UniformId("pillars", i, ".frequence"), m_pillars[i].frequence);
 		glCheckError();
 
-		GLuint signLocation = glGetUniformLocation(m_densityShader->Program, ("pillars[" + std::to_string(i) + "].frequenceSign").c_str());
-		glUniform1i(signLocation, m_pillars[i].frequenceSign);
+		m_densityShader->SetInt(UniformId("pillars", i, ".frequenceSign"), m_pillars[i].frequenceSign);
 		glCheckError();
 	}
 
 	{
-		GLuint offsetLocation = glGetUniformLocation(m_densityShader->Program, "helix.offset");
-		glUniform1f(offsetLocation, m_helix.offset);
+		m_densityShader->SetFloat("helix.offset", m_helix.offset);
 		glCheckError();
 
-		GLuint freqLocation = glGetUniformLocation(m_densityShader->Program, "helix.frequence");
-		glUniform1f(freqLocation, m_helix.frequence);
+		m_densityShader->SetFloat("helix.frequence", m_helix.frequence);
 		glCheckError();
 
-		GLuint signLocation = glGetUniformLocation(m_densityShader->Program, "helix.frequenceSign");
-		glUniform1i(signLocation, m_helix.frequenceSign);
+		m_densityShader->SetInt("helix.frequenceSign", m_helix.frequenceSign);
 		glCheckError();
 	}
 
 	{
-		GLuint offsetLocation = glGetUniformLocation(m_densityShader->Program, "shelf.offset");
-		glUniform1f(offsetLocation, m_shelf.offset);
+		m_densityShader->SetFloat("shelf.offset", m_shelf.offset);
 		glCheckError();
 
-		GLuint freqLocation = glGetUniformLocation(m_densityShader->Program, "shelf.frequence");
-		glUniform1f(freqLocation, m_shelf.frequence);
+		m_densityShader->SetFloat("shelf.frequence", m_shelf.frequence);
 		glCheckError();
 
-		GLuint signLocation = glGetUniformLocation(m_densityShader->Program, "shelf.frequenceSign");
-		glUniform1i(signLocation, m_shelf.frequenceSign);
+		m_densityShader->SetInt("shelf.frequenceSign", m_shelf.frequenceSign);
 		glCheckError();
 	}
 }
 
 void ProcedualGenerator::UpdateUniformsN()
 {
-	GLuint resLocation = glGetUniformLocation(m_normalShader->Program, "resolution");
-	glUniform3f(resLocation, 2.0f / WIDTH, 2.0f / LAYERS, 2.0f / DEPTH);
+	m_normalShader->SetVec3("resolution", glm::vec3(2.0f / WIDTH, 2.0f / LAYERS, 2.0f / DEPTH));
 	glCheckError();
 
 	glActiveTexture(GL_TEXTURE0);
-	GLint textureLoc = glGetUniformLocation(m_normalShader->Program, "densityTex");
-	glUniform1i(textureLoc, 0);
+	m_normalShader->SetInt("densityTex", 0);
 	glBindTexture(GL_TEXTURE_3D, m_densityTex.GetId());
 	glCheckError();
 }
 
+void ProcedualGenerator::ReadStatistics()
+{
+	// Stages recorded since the last mesh, e.g. noise and density passes of a new seed
+	m_statistics.Stages.clear();
+	m_stageTimer.Resolve(m_statistics.Stages);
+
+	m_statistics.HasCaseHistogram = m_collectStatistics;
+	m_statistics.SlabTriangles.clear();
+	if (!m_collectStatistics)
+		return;
+
+	// Rendering never needs the counts on the CPU, only read them back when asked for
+	SlabDrawHeader header;
+	std::vector<DrawArraysIndirectCommand> commands;
+	m_mcMesh.ReadCommands(header, commands);
+	for (size_t slab = 0; slab < commands.size(); ++slab)
+		m_statistics.SlabTriangles.push_back(commands[slab].count / 3);
+	printf("%u primitives generated!\n\n", header.TriangleCount);
+
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 3, 0);
+	glMemoryBarrier(GL_BUFFER_UPDATE_BARRIER_BIT);
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_statisticsBuffer);
+	glGetBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, sizeof(m_statistics.CaseHistogram), m_statistics.CaseHistogram);
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+	glCheckError();
+}
+
 float ProcedualGenerator::NormalizeCoord(int coord, int dim)
 {
 	return 2.0f * (coord * 1.0f / dim - 0.5f);
@@ -4,11 +4,16 @@
 #include <glm/detail/type_vec3.hpp>
 #include <random>
 #include "NoiseTexture.h"
+#include "Texture.h"
 #include <glm/mat4x4.hpp>
 #include <glm/gtx/quaternion.hpp>
 #include "BoundingBox.h"
 #include "TriplanarMesh.h"
 #include "GpuLookupTable.h"
+#include "SurfaceScatter.h"
+#include "StageTimer.h"
+#include "GeneratorStatistics.h"
+#include "DensityField.h"
 
 class Shader;
 
@@ -46,31 +51,45 @@ public:
 
 	void GenerateMcVbo();
 	TriplanarMesh* GenerateMesh();
+	void GenerateDecorations();
 
 	GLuint GetVertexCountMc() const;
 	GLuint GetVertexCountTf() const;
 
 	const Texture& GetDensityTexture() const;
 	const Texture& GetNormalTexture() const;
+	SurfaceScatter& GetScatter();
+	const GeneratorStatistics& GetStatistics() const;
+	DensityField& GetDensityField();
+	// Incremented by every GenerateMesh, lets caches notice a new terrain
+	GLuint GetMeshGeneration() const;
+	// Called every frame. Once the triangle count of the last mesh is available and it exceeded the
+	// mesh buffer, the buffer is grown and the mesh generated again. Returns true in that case.
+	bool PollMeshOverflow();
 
 	void SetRandomSeed(int seed);
 	void SetStartLayer(int layer);
 	void SetResolution(glm::ivec3 cubesPerDimension);
 	void SetNoiseScale(float scale);
 	void SetIsoLevel(float isoLevel);
+	void SetCollectStatistics(bool collectStatistics);
 
 	void SetGeometryScale(glm::vec3 scale);
 	const glm::vec3 GetGeometryScale() const;
 
 	static const int WIDTH = 96, DEPTH = 96, LAYERS = 256;
+	// Share of the worst case (5 triangles per cube) reserved for the surface mesh
+	static const int MESH_CAPACITY_DIVISOR = 16;
 
 protected:
 	void SetupMC();
 	void SetupDensity();
 
 	void UpdateUniformsMc();
+	void UpdateUniformsNoise(const Shader& shader);
 	void UpdateUniformsD();
 	void UpdateUniformsN();
+	void ReadStatistics();
 
 	static float NormalizeCoord(int coord, int dim);
 	static int ToSignBit(int random);
@@ -82,7 +101,7 @@ protected:
 	Noise* m_noise;
 
 	Texture m_densityTex, m_normalTex;
-	GLuint m_vaoMc = 0, m_vboMc = 0, m_tboMc = 0, m_vaoD = 0, m_vboD = 0, m_fboD = 0, m_fboN;
+	GLuint m_vaoMc = 0, m_vboMc = 0, m_vaoD = 0, m_vboD = 0, m_fboD = 0, m_fboN;
 
 	GLuint m_vertexCount = 0;
 
@@ -93,10 +112,24 @@ protected:
 	float m_noiseScale;
 	float m_isoLevel;
 
-	Shader* m_marchingCubeShader, *m_densityShader, *m_normalShader;
+	Shader* m_marchingCubeShader, *m_densityShader, *m_normalShader, *m_densityFieldShader, *m_slabCommandShader, *m_slabBoundsShader;
+	// Primitives written per slab, resolved into the command buffer of the mesh
+	GLuint m_slabQueries[TriplanarMesh::SLAB_COUNT];
+	// Triangles the last mesh generated, including the ones that didn't fit into the buffer
+	GLuint m_generatedQuery;
+	bool m_isGeneratedPending;
 	GpuLookupTable m_lookupTable;
 
 	TriplanarMesh m_mcMesh;
+	SurfaceScatter m_scatter;
+	DensityField m_densityField;
+	int m_seed;
+
+	StageTimer m_stageTimer;
+	GeneratorStatistics m_statistics;
+	GLuint m_statisticsBuffer;
+	bool m_collectStatistics;
+	GLuint m_meshGeneration;
 
 	std::default_random_engine m_random;
 	std::uniform_int_distribution<int> m_randomAngle;
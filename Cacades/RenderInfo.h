@@ -1,15 +1,42 @@
 #pragma once
 #include <glm/detail/type_vec3.hpp>
 #include "Model.h"
+#include "AntiAliasingInfo.h"
 
 struct RenderInfo
 {
 	float NormalMapFactor = 1.0f;
 	ShadowMode ShadowMode = PcfShadows;
+	PointShadowMode PointShadowMode = FaceCulledShadows;
 	bool EnableLight = true;
 	bool EnableShadows = true;
 	bool DrawLightPosition = true;
 	bool RenderPath = false;
+	bool EnableDecorations = true;
+	// Shade only the lights of the fragment's froxel instead of every light
+	bool ClusteredLighting = true;
+	// Fill a G-buffer with the terrain and light it in one fullscreen pass
+	bool DeferredShading = false;
+	// Lay down the terrain depth first and shade it with GL_EQUAL
+	bool DepthPrePass = false;
+	// Terrain slabs farther away are drawn without tessellation
+	float TessellationDistance = 8.0f;
+	// Cull the terrain slabs against the camera and light frustums on the GPU
+	bool GpuCulling = true;
+	// Skip terrain slabs hidden behind the depth of the slabs visible in the last frame, needs GpuCulling
+	bool OcclusionCulling = true;
+	// Measured GPU milliseconds of the scene pass without and with depth pre-pass
+	float ScenePassTimes[2] = { 0.0f, 0.0f };
+	MeshFormat ExportFormat = PlyFormat;
+	AntiAliasingInfo AntiAliasing;
+	// Scale the scene resolution to hold the GPU frame time below TargetFrameTime
+	bool DynamicResolution = true;
+	float TargetFrameTime = 15.0f;
+	float MinRenderScale = 0.5f;
+	float MaxRenderScale = 1.0f;
+	// Current scale and the measured GPU milliseconds of the whole frame
+	float RenderScale = 1.0f;
+	float FrameTime = 0.0f;
 
 	//Generator
 	glm::ivec3 Resolution;
@@ -23,4 +50,30 @@ struct RenderInfo
 	int DisplacementInitialSteps = 16;
 	int DisplacementRefinementSteps = 16;
 	float DisplacementScale = 0.025f;
+
+	float TriplanarBlendThreshold = 0.05f;
+	float TriplanarDominantAxisDistance = 15.0f;
+	bool TriplanarDominantAxisOnly = true;
+
+	// Cube map faces or cascades a light may update per frame
+	int ShadowFacesPerFrame = 2;
+	// GPU milliseconds per frame the shadow scheduler may spend
+	float ShadowBudget = 2.0f;
+
+	// Cascades of directional lights, covering the view up to ShadowDistance
+	int ShadowCascades = 4;
+	float ShadowDistance = 40.0f;
+	// 0 splits the distance uniformly, 1 logarithmically
+	float CascadeSplitLambda = 0.75f;
+
+	// Texels per side of the shadow atlas shared by all lights
+	int ShadowAtlasSize = 4096;
+	// Tile size of a face covering the whole view, and of lights below the importance threshold
+	int ShadowMaxTile = 1024;
+	int ShadowLowTile = 128;
+	float ShadowImportanceThreshold = 0.01f;
+	// VSM tiles are blurred after rendering and shrunk by this factor
+	float VsmTileScale = 0.5f;
+	// Gaussian radius in texels, 0 disables the blur
+	int VsmBlurRadius = 2;
 };
@@ -0,0 +1,242 @@
+#include "RenderQueue.h"
+#include "BaseObject.h"
+#include "CommandCuller.h"
+#include "Shader.h"
+#include "Global.h"
+#include <algorithm>
+#include <cstring>
+
+// Key layout, most significant first: pass (4 bits), program (12), material (16), depth (32)
+static const int PASS_SHIFT = 60;
+static const int PROGRAM_SHIFT = 48;
+static const int MATERIAL_SHIFT = 32;
+
+Material::Material()
+{
+	static GLuint nextId = 0;
+	Id = ++nextId;
+	Target = GL_TEXTURE_2D;
+	for (int i = 0; i < MAX_TEXTURES; ++i)
+		Textures[i] = 0;
+}
+
+DrawPacket::DrawPacket()
+	: Program(nullptr), Surface(nullptr), Object(nullptr), Vao(0), Mode(GL_TRIANGLES), First(0), Count(0),
+	IndexType(GL_NONE), PatchVertices(0), CullFace(false), IndirectBuffer(0), IndirectOffset(0), BoundsBuffer(0), BoundsFirst(0), VisibilityBuffer(0), HasBounds(false), BoundsMin(0), BoundsMax(0),
+	LayerMask(0), InstanceCount(1), CulledOffset(-1), HasPosition(true), Position(0)
+{
+}
+
+RenderQueue::RenderQueue() : m_viewPos(0), m_drawCount(0), m_culledCount(0), m_pendingCulled(0), m_layerFrustums(nullptr), m_layerMask(0), m_layered(false),
+	m_culler(nullptr), m_hasCulledCommands(false)
+{
+}
+
+void RenderQueue::SetViewPosition(glm::vec3 viewPos)
+{
+	m_viewPos = viewPos;
+}
+
+glm::vec3 RenderQueue::GetViewPosition() const
+{
+	return m_viewPos;
+}
+
+void RenderQueue::SetLayerFrustums(const Frustum* frustums, GLuint layerMask, bool layered)
+{
+	m_layerFrustums = frustums;
+	m_layerMask = layerMask;
+	m_layered = layered;
+}
+
+void RenderQueue::ClearLayerFrustums()
+{
+	SetLayerFrustums(nullptr, 0, false);
+}
+
+void RenderQueue::SetCommandCuller(CommandCuller* culler)
+{
+	m_culler = culler;
+}
+
+void RenderQueue::Submit(RenderPass pass, const DrawPacket& packet)
+{
+	if (packet.Count == 0 || packet.Program == nullptr)
+		return;
+
+	Entry entry;
+	entry.Key = MakeKey(pass, packet);
+	entry.Index = m_packets.size();
+
+	if (m_layerFrustums == nullptr)
+	{
+		m_entries.push_back(entry);
+		m_packets.push_back(packet);
+		return;
+	}
+
+	GLuint layers = 0;
+	GLsizei layerCount = 0;
+	for (int layer = 0; (m_layerMask >> layer) != 0; ++layer)
+	{
+		if (!(m_layerMask & (1u << layer)))
+			continue;
+
+		if (!packet.HasBounds || m_layerFrustums[layer].Intersects(packet.BoundsMin, packet.BoundsMax))
+		{
+			layers |= 1u << layer;
+			++layerCount;
+		}
+	}
+
+	if (layers == 0)
+	{
+		++m_pendingCulled;
+		return;
+	}
+
+	m_entries.push_back(entry);
+	m_packets.push_back(packet);
+	m_packets.back().LayerMask = layers;
+	m_packets.back().InstanceCount = m_layered ? layerCount : 1;
+
+	// Non-layered packets are drawn once, so their commands can only be culled against a single frustum
+	bool cullCommands = m_culler && packet.IndirectBuffer != 0 && packet.BoundsBuffer != 0 && packet.Object;
+	if (cullCommands && (m_layered || layerCount == 1))
+	{
+		m_packets.back().CulledOffset = m_culler->Cull(packet, m_layerFrustums, layers);
+		m_hasCulledCommands = true;
+		// Callers may still set uniforms of the program after submitting
+		glUseProgram(packet.Program->Program);
+	}
+}
+
+GLuint64 RenderQueue::MakeKey(RenderPass pass, const DrawPacket& packet) const
+{
+	// Non-negative floats keep their order when compared as integers
+	GLuint depthBits = 0;
+	if (packet.HasPosition)
+	{
+		GLfloat depth = glm::length(packet.Position - m_viewPos);
+		memcpy(&depthBits, &depth, sizeof(depthBits));
+	}
+
+	GLuint64 program = packet.Program->Program & 0xFFF;
+	GLuint64 material = packet.Surface ? packet.Surface->Id & 0xFFFF : 0;
+
+	return GLuint64(pass) << PASS_SHIFT | program << PROGRAM_SHIFT | material << MATERIAL_SHIFT | depthBits;
+}
+
+void RenderQueue::Flush()
+{
+	// The cache can't see binds made since the last flush
+	m_state.Invalidate();
+	m_state.ResetCounters();
+	m_drawCount = 0;
+	m_culledCount = m_pendingCulled;
+	m_pendingCulled = 0;
+
+	if (m_hasCulledCommands)
+	{
+		m_culler->Barrier();
+		m_hasCulledCommands = false;
+	}
+
+	std::sort(m_entries.begin(), m_entries.end());
+	for (std::vector<Entry>::const_iterator it = m_entries.begin(); it != m_entries.end(); ++it)
+		Execute(m_packets[it->Index]);
+
+	glBindVertexArray(0);
+	glCheckError();
+
+	Clear();
+}
+
+void RenderQueue::Clear()
+{
+	m_packets.clear();
+	m_entries.clear();
+}
+
+void RenderQueue::Execute(const DrawPacket& packet)
+{
+	m_state.UseProgram(*packet.Program);
+
+	if (packet.Surface)
+	{
+		for (int i = 0; i < Material::MAX_TEXTURES; ++i)
+		{
+			if (packet.Surface->Textures[i] != 0)
+				m_state.BindTexture(Material::FIRST_UNIT + i, packet.Surface->Target, packet.Surface->Textures[i]);
+		}
+	}
+
+	if (packet.Object)
+		packet.Object->SetDrawUniforms(*packet.Program);
+
+	if (packet.LayerMask != 0)
+		packet.Program->SetInt("layerMask", packet.LayerMask);
+
+	m_state.SetCullFace(packet.CullFace);
+	m_state.BindVertexArray(packet.Vao);
+
+	if (packet.Mode == GL_PATCHES)
+		m_state.SetPatchVertices(packet.PatchVertices);
+
+	if (packet.IndirectBuffer != 0)
+		ExecuteIndirect(packet);
+	else if (packet.IndexType == GL_NONE)
+		glDrawArraysInstanced(packet.Mode, packet.First, packet.Count, packet.InstanceCount);
+	else
+		glDrawElementsInstanced(packet.Mode, packet.Count, packet.IndexType, nullptr, packet.InstanceCount);
+	glCheckError();
+
+	++m_drawCount;
+}
+
+void RenderQueue::ExecuteIndirect(const DrawPacket& packet)
+{
+	if (packet.InstanceCount == 1)
+		DrawCommands(packet, 0);
+	else
+	{
+		// The instance count is part of the commands, so layered packets are drawn once per layer instead
+		int range = 0;
+		for (int layer = 0; (packet.LayerMask >> layer) != 0; ++layer)
+		{
+			if (!(packet.LayerMask & (1u << layer)))
+				continue;
+
+			packet.Program->SetInt("layerMask", 1u << layer);
+			DrawCommands(packet, range++);
+		}
+	}
+}
+
+void RenderQueue::DrawCommands(const DrawPacket& packet, int range)
+{
+	if (packet.CulledOffset >= 0)
+	{
+		m_culler->Draw(packet.Mode, packet.CulledOffset + range * CommandCuller::GetRangeSize(packet.Count), packet.Count);
+		return;
+	}
+
+	glBindBuffer(GL_DRAW_INDIRECT_BUFFER, packet.IndirectBuffer);
+	glMultiDrawArraysIndirect(packet.Mode, (const GLvoid*)packet.IndirectOffset, packet.Count, 0);
+	glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+}
+
+GLuint RenderQueue::GetDrawCount() const
+{
+	return m_drawCount;
+}
+
+GLuint RenderQueue::GetCulledCount() const
+{
+	return m_culledCount;
+}
+
+const GlStateCache& RenderQueue::GetStateCache() const
+{
+	return m_state;
+}
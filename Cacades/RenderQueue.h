@@ -0,0 +1,141 @@
+#pragma once
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+#include <vector>
+#include "GlStateCache.h"
+#include "Frustum.h"
+
+class Shader;
+class BaseObject;
+class CommandCuller;
+
+enum RenderPass
+{
+	ShadowPass,
+	// Opaque geometry drawn depth only, like shadows without material textures
+	DepthPass,
+	OpaquePass,
+	RenderPassCount
+};
+
+// Textures bound to consecutive units starting at FIRST_UNIT, 0 leaves a unit untouched
+struct Material
+{
+	Material();
+
+	static const int MAX_TEXTURES = 9;
+	static const GLuint FIRST_UNIT = 1;
+
+	GLuint Textures[MAX_TEXTURES];
+	// GL_TEXTURE_2D or GL_TEXTURE_2D_ARRAY, shared by all textures
+	GLenum Target;
+	// Sort key component, unique per material
+	GLuint Id;
+};
+
+struct DrawPacket
+{
+	DrawPacket();
+
+	// Program, material and draw call
+	Shader* Program;
+	const Material* Surface;
+	// Sets the per-draw uniforms, may be null
+	const BaseObject* Object;
+
+	GLuint Vao;
+	GLenum Mode;
+	GLint First;
+	GLsizei Count;
+	// GL_NONE draws arrays
+	GLenum IndexType;
+	GLint PatchVertices;
+	bool CullFace;
+	// Non-zero draws Count commands of this GL_DRAW_INDIRECT_BUFFER starting at IndirectOffset with
+	// glMultiDrawArraysIndirect, First and IndexType are ignored then
+	GLuint IndirectBuffer;
+	GLintptr IndirectOffset;
+	// Object space min and max (two vec4) per command, starting at BoundsFirst. Lets the queue cull the
+	// commands against its layer frustums on the GPU, needs Object for the model matrix.
+	GLuint BoundsBuffer;
+	GLint BoundsFirst;
+	// One uint per command indexed like the bounds, whether the last occlusion test found it visible.
+	// Zero leaves the packet out of occlusion culling.
+	GLuint VisibilityBuffer;
+
+	// World space bounds, packets without bounds are never culled
+	bool HasBounds;
+	glm::vec3 BoundsMin;
+	glm::vec3 BoundsMax;
+
+	// Filled in by the queue while layer frustums are set, uploaded as the layerMask uniform
+	GLuint LayerMask;
+	GLsizei InstanceCount;
+	// Offset of the GPU culled commands in the buffer of the culler, one range per layer, -1 if not culled
+	GLintptr CulledOffset;
+
+	// Sort position, used for front to back ordering. Packets without one sort by program and material only.
+	bool HasPosition;
+	glm::vec3 Position;
+};
+
+// Collects draw packets and executes them sorted by pass, program, material and depth.
+// Redundant program, vertex array and texture binds between packets are elided.
+class RenderQueue
+{
+public:
+	RenderQueue();
+
+	void SetViewPosition(glm::vec3 viewPos);
+	glm::vec3 GetViewPosition() const;
+	// Packets submitted afterwards are culled against the frustums selected by layerMask, one per layer
+	// of a layered target, and remember the layers they touch. Layered packets are drawn with one instance
+	// per touched layer, the vertex shader picks the layer from layerMask and gl_InstanceID.
+	void SetLayerFrustums(const Frustum* frustums, GLuint layerMask, bool layered);
+	void ClearLayerFrustums();
+	// Indirect packets with bounds submitted afterwards are culled per command on the GPU, null disables it
+	void SetCommandCuller(CommandCuller* culler);
+	void Submit(RenderPass pass, const DrawPacket& packet);
+	void Flush();
+	void Clear();
+
+	// Statistics of the last flush
+	GLuint GetDrawCount() const;
+	GLuint GetCulledCount() const;
+	const GlStateCache& GetStateCache() const;
+
+protected:
+	struct Entry
+	{
+		GLuint64 Key;
+		size_t Index;
+
+		bool operator<(const Entry& other) const
+		{
+			return Key < other.Key;
+		}
+	};
+
+	GLuint64 MakeKey(RenderPass pass, const DrawPacket& packet) const;
+	void Execute(const DrawPacket& packet);
+	void ExecuteIndirect(const DrawPacket& packet);
+	// Draws the commands of a packet, range selects the culled commands of the range-th layer
+	void DrawCommands(const DrawPacket& packet, int range);
+
+	std::vector<DrawPacket> m_packets;
+	std::vector<Entry> m_entries;
+	glm::vec3 m_viewPos;
+	GlStateCache m_state;
+	GLuint m_drawCount;
+	GLuint m_culledCount;
+	// Packets culled since the last flush, reported by the next one
+	GLuint m_pendingCulled;
+
+	const Frustum* m_layerFrustums;
+	GLuint m_layerMask;
+	bool m_layered;
+
+	CommandCuller* m_culler;
+	// Packets culled on the GPU since the last flush, their commands need a barrier
+	bool m_hasCulledCommands;
+};
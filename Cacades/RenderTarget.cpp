@@ -0,0 +1,195 @@
+#include "RenderTarget.h"
+#include "Global.h"
+#include "Shader.h"
+#include <glm/glm.hpp>
+
+RenderTarget::RenderTarget() : m_fbo(0), m_colorBuffer(0), m_depthBuffer(0), m_resolveFbo(0), m_color(0), m_depth(0), m_vao(0), m_width(0), m_height(0), m_samples(0), m_scale(1.0f)
+{
+	m_fxaaShader = new Shader("./shaders/Fullscreen.vert", nullptr, "./shaders/Fxaa.frag");
+	m_fxaaShader->Test("Fxaa");
+
+	// The fullscreen triangle is generated from gl_VertexID
+	glGenVertexArrays(1, &m_vao);
+	glCheckError();
+}
+
+RenderTarget::~RenderTarget()
+{
+	Delete();
+	glDeleteVertexArrays(1, &m_vao);
+	delete m_fxaaShader;
+}
+
+void RenderTarget::Resize(GLsizei width, GLsizei height, GLsizei samples)
+{
+	// Minimized windows report a size of 0
+	if (width == 0 || height == 0)
+		return;
+
+	samples = samples > 1 ? samples : 0;
+	if (width == m_width && height == m_height && samples == m_samples)
+		return;
+
+	m_width = width;
+	m_height = height;
+	m_samples = samples;
+	Delete();
+	Allocate();
+}
+
+void RenderTarget::SetScale(float scale)
+{
+	m_scale = glm::clamp(scale, 0.01f, 1.0f);
+}
+
+void RenderTarget::Bind() const
+{
+	glBindFramebuffer(GL_FRAMEBUFFER, m_fbo);
+	glViewport(0, 0, GetViewportWidth(), GetViewportHeight());
+	glCheckError();
+}
+
+void RenderTarget::Present(GLsizei windowWidth, GLsizei windowHeight, bool fxaa) const
+{
+	GLsizei width = GetViewportWidth();
+	GLsizei height = GetViewportHeight();
+	if (m_samples > 0)
+	{
+		glBindFramebuffer(GL_READ_FRAMEBUFFER, m_fbo);
+		glBindFramebuffer(GL_DRAW_FRAMEBUFFER, m_resolveFbo);
+		glBlitFramebuffer(0, 0, width, height, 0, 0, width, height, GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT, GL_NEAREST);
+		glCheckError();
+	}
+
+	// A filtered blit of a scaled viewport would blend in the stale texels around it
+	bool scaled = width != m_width || height != m_height;
+	if (!fxaa && !scaled)
+	{
+		glBindFramebuffer(GL_READ_FRAMEBUFFER, m_resolveFbo);
+		glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
+		glBlitFramebuffer(0, 0, width, height, 0, 0, windowWidth, windowHeight, GL_COLOR_BUFFER_BIT, GL_LINEAR);
+		glBindFramebuffer(GL_FRAMEBUFFER, 0);
+		glViewport(0, 0, windowWidth, windowHeight);
+		glCheckError();
+		return;
+	}
+
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	glViewport(0, 0, windowWidth, windowHeight);
+	glDisable(GL_DEPTH_TEST);
+
+	m_fxaaShader->Use();
+	m_fxaaShader->SetInt("source", 0);
+	m_fxaaShader->SetVec2("inverseSourceSize", 1.0f / glm::vec2(m_width, m_height));
+	m_fxaaShader->SetVec2("inverseTargetSize", 1.0f / glm::vec2(windowWidth, windowHeight));
+	m_fxaaShader->SetVec2("sourceScale", glm::vec2(width, height) / glm::vec2(m_width, m_height));
+	m_fxaaShader->SetBool("antiAliasing", fxaa);
+	glActiveTexture(GL_TEXTURE0);
+	glBindTexture(GL_TEXTURE_2D, m_color);
+
+	glBindVertexArray(m_vao);
+	glDrawArrays(GL_TRIANGLES, 0, 3);
+	glBindVertexArray(0);
+	glEnable(GL_DEPTH_TEST);
+	glCheckError();
+}
+
+GLuint RenderTarget::GetFramebuffer() const
+{
+	return m_fbo;
+}
+
+GLsizei RenderTarget::GetWidth() const
+{
+	return m_width;
+}
+
+GLsizei RenderTarget::GetHeight() const
+{
+	return m_height;
+}
+
+GLsizei RenderTarget::GetViewportWidth() const
+{
+	return glm::max(GLsizei(m_width * m_scale + 0.5f), 1);
+}
+
+GLsizei RenderTarget::GetViewportHeight() const
+{
+	return glm::max(GLsizei(m_height * m_scale + 0.5f), 1);
+}
+
+float RenderTarget::GetScale() const
+{
+	return m_scale;
+}
+
+GLsizei RenderTarget::GetSamples() const
+{
+	return m_samples;
+}
+
+void RenderTarget::Allocate()
+{
+	glGenTextures(1, &m_color);
+	glBindTexture(GL_TEXTURE_2D, m_color);
+	glTexStorage2D(GL_TEXTURE_2D, 1, GL_RGBA16F, m_width, m_height);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+	glGenTextures(1, &m_depth);
+	glBindTexture(GL_TEXTURE_2D, m_depth);
+	glTexStorage2D(GL_TEXTURE_2D, 1, GL_DEPTH_COMPONENT32F, m_width, m_height);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	glBindTexture(GL_TEXTURE_2D, 0);
+	glCheckError();
+
+	glGenFramebuffers(1, &m_resolveFbo);
+	glBindFramebuffer(GL_FRAMEBUFFER, m_resolveFbo);
+	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, m_color, 0);
+	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, m_depth, 0);
+	glCheckFrameBuffer();
+	glCheckError();
+
+	if (m_samples == 0)
+	{
+		m_fbo = m_resolveFbo;
+		glBindFramebuffer(GL_FRAMEBUFFER, 0);
+		return;
+	}
+
+	glGenRenderbuffers(1, &m_colorBuffer);
+	glBindRenderbuffer(GL_RENDERBUFFER, m_colorBuffer);
+	glRenderbufferStorageMultisample(GL_RENDERBUFFER, m_samples, GL_RGBA16F, m_width, m_height);
+	glGenRenderbuffers(1, &m_depthBuffer);
+	glBindRenderbuffer(GL_RENDERBUFFER, m_depthBuffer);
+	glRenderbufferStorageMultisample(GL_RENDERBUFFER, m_samples, GL_DEPTH_COMPONENT32F, m_width, m_height);
+	glBindRenderbuffer(GL_RENDERBUFFER, 0);
+	glCheckError();
+
+	glGenFramebuffers(1, &m_fbo);
+	glBindFramebuffer(GL_FRAMEBUFFER, m_fbo);
+	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, m_colorBuffer);
+	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, m_depthBuffer);
+	glCheckFrameBuffer();
+
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	glCheckError();
+}
+
+void RenderTarget::Delete()
+{
+	if (m_fbo != m_resolveFbo)
+		glDeleteFramebuffers(1, &m_fbo);
+	glDeleteFramebuffers(1, &m_resolveFbo);
+	glDeleteRenderbuffers(1, &m_colorBuffer);
+	glDeleteRenderbuffers(1, &m_depthBuffer);
+	glDeleteTextures(1, &m_color);
+	glDeleteTextures(1, &m_depth);
+	m_fbo = m_resolveFbo = 0;
+	m_colorBuffer = m_depthBuffer = 0;
+	m_color = m_depth = 0;
+}
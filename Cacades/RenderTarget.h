@@ -0,0 +1,55 @@
+#pragma once
+#include <GL/glew.h>
+
+class Shader;
+
+// Offscreen HDR colour and depth target the scene is rendered into, optionally multisampled.
+// Present resolves the samples and draws the result to the window, which may have a different size,
+// either with a plain filtered blit or through the FXAA pass, which also upscales scaled viewports.
+// The scale renders into a smaller viewport of the allocated target, so it can change every frame
+// without reallocating anything.
+class RenderTarget
+{
+public:
+	RenderTarget();
+	~RenderTarget();
+
+	// Reallocates the target when the size or sample count changed, sizes of 0 are ignored
+	void Resize(GLsizei width, GLsizei height, GLsizei samples);
+	// Fraction of the target size that is rendered, clamped to (0, 1]
+	void SetScale(float scale);
+	// Binds the framebuffer the scene is rendered into and sets the viewport to the target size
+	void Bind() const;
+	// Resolves the target and draws it into the default framebuffer of the given size
+	void Present(GLsizei windowWidth, GLsizei windowHeight, bool fxaa) const;
+
+	GLuint GetFramebuffer() const;
+	GLsizei GetWidth() const;
+	GLsizei GetHeight() const;
+	// Size of the scaled viewport
+	GLsizei GetViewportWidth() const;
+	GLsizei GetViewportHeight() const;
+	float GetScale() const;
+	GLsizei GetSamples() const;
+
+protected:
+	void Allocate();
+	void Delete();
+
+	// Framebuffer rendered into, equals m_resolveFbo without multisampling
+	GLuint m_fbo;
+	GLuint m_colorBuffer;
+	GLuint m_depthBuffer;
+
+	// Single sampled textures the multisampled buffers are resolved into
+	GLuint m_resolveFbo;
+	GLuint m_color;
+	GLuint m_depth;
+
+	GLuint m_vao;
+	GLsizei m_width;
+	GLsizei m_height;
+	GLsizei m_samples;
+	float m_scale;
+	Shader* m_fxaaShader;
+};
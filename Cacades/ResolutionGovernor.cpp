@@ -0,0 +1,59 @@
+#include "ResolutionGovernor.h"
+#include <glm/glm.hpp>
+
+// Scales are multiples of this
+static const float SCALE_STEP = 0.05f;
+// Frames have to be this much faster than the target before the scale grows again
+static const float HYSTERESIS = 0.15f;
+// Frames without changes after shrinking and growing, the timer results lag behind by a few frames
+static const int SHRINK_COOLDOWN = 4;
+static const int GROW_COOLDOWN = 15;
+
+ResolutionGovernor::ResolutionGovernor() : m_target(15.0f), m_minScale(0.5f), m_maxScale(1.0f), m_scale(1.0f), m_cooldown(0)
+{
+}
+
+void ResolutionGovernor::SetTarget(float milliseconds)
+{
+	m_target = milliseconds;
+}
+
+void ResolutionGovernor::SetScaleRange(float minScale, float maxScale)
+{
+	m_minScale = minScale;
+	m_maxScale = glm::max(minScale, maxScale);
+	m_scale = glm::clamp(m_scale, m_minScale, m_maxScale);
+}
+
+float ResolutionGovernor::Update(float gpuMilliseconds)
+{
+	if (gpuMilliseconds <= 0.0f)
+		return m_scale;
+
+	if (m_cooldown > 0)
+	{
+		--m_cooldown;
+		return m_scale;
+	}
+
+	float scale = m_scale;
+	if (gpuMilliseconds > m_target)
+	{
+		scale = glm::floor(m_scale * glm::sqrt(m_target / gpuMilliseconds) / SCALE_STEP) * SCALE_STEP;
+		m_cooldown = SHRINK_COOLDOWN;
+	}
+	else if (gpuMilliseconds < m_target * (1.0f - HYSTERESIS))
+	{
+		// Rounded to the step as well, so float error doesn't accumulate and cost the next shrink a step
+		scale = glm::round((m_scale + SCALE_STEP) / SCALE_STEP) * SCALE_STEP;
+		m_cooldown = GROW_COOLDOWN;
+	}
+
+	m_scale = glm::clamp(scale, m_minScale, m_maxScale);
+	return m_scale;
+}
+
+float ResolutionGovernor::GetScale() const
+{
+	return m_scale;
+}
@@ -0,0 +1,26 @@
+#pragma once
+
+// Picks the render scale for the next frame from the measured GPU frame time.
+// Frames over the target shrink the scale right away by the square root of the overshoot, as the cost
+// is roughly proportional to the pixel count. Frames well below the target grow it one step at a time.
+// Scales are quantized to steps and every change is followed by a cooldown, so the delayed and noisy
+// timer results don't make the resolution oscillate.
+class ResolutionGovernor
+{
+public:
+	ResolutionGovernor();
+
+	void SetTarget(float milliseconds);
+	void SetScaleRange(float minScale, float maxScale);
+
+	// Feeds the smoothed GPU frame time, 0 if no result arrived yet, and returns the new scale
+	float Update(float gpuMilliseconds);
+	float GetScale() const;
+
+protected:
+	float m_target;
+	float m_minScale;
+	float m_maxScale;
+	float m_scale;
+	int m_cooldown;
+};
@@ -6,9 +6,11 @@
 #include "Shlwapi.h"
 #include "Pathcch.h"
 #include "Global.h"
+#include <cstring>
+#include <glm/gtc/type_ptr.hpp>
 
 
-Shader::Shader(const GLchar* computePath)
+Shader::Shader(const GLchar* computePath) : Program(0), m_transformFeedbackVariables(nullptr), m_isTempValid(false), m_isValid(false), m_isDirty(true)
 {
 	if (computePath != nullptr)
 		m_sourceFiles.push_back(SourceFile{ computePath, GL_COMPUTE_SHADER });
@@ -77,7 +79,7 @@ void Shader::Load()
 
 	GLuint* shaders = new GLuint[m_sourceFiles.size()] {0};
 	
-	for (int i = 0; i < m_sourceFiles.size(); ++i)
+	for (size_t i = 0; i < m_sourceFiles.size(); ++i)
 	{
 		shaders[i] = LoadShader(m_sourceFiles[i].path, m_sourceFiles[i].type, m_isTempValid);
 		glAttachShader(tempProgram, shaders[i]);
@@ -99,6 +101,7 @@ void Shader::Load()
 			glDeleteProgram(Program);
 			Program = tempProgram;
 			m_isValid = true;
+			Reflect();
 		}
 		else
 		{
@@ -120,7 +123,7 @@ void Shader::Load()
 
 
 	// Delete the shaders as they're linked into our program now and no longer necessery
-	for (int i=0; i < m_sourceFiles.size(); ++i)
+	for (size_t i=0; i < m_sourceFiles.size(); ++i)
 	{
 		glDeleteShader(shaders[i]);
 	}
@@ -230,6 +233,8 @@ GLchar* Shader::GetShaderName(GLenum shaderType)
 		return "GEOMETRY";
 	case GL_FRAGMENT_SHADER:
 		return "FRAGMENT";
+	case GL_COMPUTE_SHADER:
+		return "COMPUTE";
 	default:
 		return "UNKNOWN";
 	}
@@ -279,3 +284,191 @@ void Shader::Test(const char* debugMessage)
 			Use();
 		}
 }
+
+void Shader::Reflect()
+{
+	m_uniforms.clear();
+	m_uniformIndices.clear();
+	m_uniformBlocks.clear();
+	m_storageBlocks.clear();
+
+	GLint maxLength;
+	glGetProgramiv(Program, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxLength);
+	std::vector<GLchar> name(maxLength + 1);
+
+	GLint uniformCount;
+	glGetProgramiv(Program, GL_ACTIVE_UNIFORMS, &uniformCount);
+	for (GLuint i = 0; i < GLuint(uniformCount); ++i)
+	{
+		GLint size;
+		GLenum type;
+		glGetActiveUniform(Program, i, GLsizei(name.size()), nullptr, &size, &type, name.data());
+		GLint location = glGetUniformLocation(Program, name.data());
+		// Members of uniform blocks have no location
+		if (location == -1)
+			continue;
+
+		std::string uniformName(name.data());
+		size_t arrayStart = uniformName.size() > 3 ? uniformName.rfind("[0]") : std::string::npos;
+		if (arrayStart == std::string::npos || arrayStart != uniformName.size() - 3)
+		{
+			AddUniform(uniformName, location, type);
+			continue;
+		}
+
+		// Arrays report only their first element, register the array name and every element
+		std::string arrayName = uniformName.substr(0, arrayStart);
+		AddUniform(arrayName, location, type);
+		for (GLint element = 0; element < size; ++element)
+		{
+			std::string elementName = arrayName + "[" + std::to_string(element) + "]";
+			AddUniform(elementName, glGetUniformLocation(Program, elementName.c_str()), type);
+		}
+	}
+
+	GLint blockCount;
+	glGetProgramiv(Program, GL_ACTIVE_UNIFORM_BLOCKS, &blockCount);
+	for (GLuint i = 0; i < GLuint(blockCount); ++i)
+	{
+		GLint length, binding;
+		glGetActiveUniformBlockiv(Program, i, GL_UNIFORM_BLOCK_NAME_LENGTH, &length);
+		glGetActiveUniformBlockiv(Program, i, GL_UNIFORM_BLOCK_BINDING, &binding);
+		std::vector<GLchar> blockName(length + 1);
+		glGetActiveUniformBlockName(Program, i, length + 1, nullptr, blockName.data());
+		m_uniformBlocks[UniformId(blockName.data()).Hash] = BlockSlot{ i, binding };
+	}
+
+	GLint storageCount = 0;
+	glGetProgramInterfaceiv(Program, GL_SHADER_STORAGE_BLOCK, GL_ACTIVE_RESOURCES, &storageCount);
+	for (GLuint i = 0; i < GLuint(storageCount); ++i)
+	{
+		GLchar blockName[256];
+		glGetProgramResourceName(Program, GL_SHADER_STORAGE_BLOCK, i, sizeof(blockName), nullptr, blockName);
+		m_storageBlocks[UniformId(blockName).Hash] = i;
+	}
+	glCheckError();
+}
+
+void Shader::AddUniform(const std::string& name, GLint location, GLenum type)
+{
+	UniformId id(name);
+	std::unordered_map<GLuint, size_t>::const_iterator it = m_uniformIndices.find(id.Hash);
+	if (it != m_uniformIndices.end())
+	{
+		if (m_uniforms[it->second].Location != location)
+			std::cout << "ERROR::SHADER::UNIFORM_HASH_COLLISION " << name << std::endl;
+		return;
+	}
+
+	UniformSlot slot;
+	slot.Location = location;
+	slot.Type = type;
+	slot.HasValue = false;
+	m_uniformIndices[id.Hash] = m_uniforms.size();
+	m_uniforms.push_back(slot);
+}
+
+Shader::UniformSlot* Shader::FindUpload(UniformId id, const void* value, size_t size) const
+{
+	std::unordered_map<GLuint, size_t>::const_iterator it = m_uniformIndices.find(id.Hash);
+	if (it == m_uniformIndices.end())
+		return nullptr;
+
+	UniformSlot& slot = m_uniforms[it->second];
+	if (slot.HasValue && memcmp(slot.Value, value, size) == 0)
+		return nullptr;
+
+	memcpy(slot.Value, value, size);
+	slot.HasValue = true;
+	return &slot;
+}
+
+bool Shader::HasUniform(UniformId id) const
+{
+	return m_uniformIndices.find(id.Hash) != m_uniformIndices.end();
+}
+
+GLint Shader::GetUniformLocation(UniformId id) const
+{
+	std::unordered_map<GLuint, size_t>::const_iterator it = m_uniformIndices.find(id.Hash);
+	return it != m_uniformIndices.end() ? m_uniforms[it->second].Location : -1;
+}
+
+void Shader::SetBool(UniformId id, bool value) const
+{
+	SetInt(id, value);
+}
+
+void Shader::SetInt(UniformId id, GLint value) const
+{
+	if (UniformSlot* slot = FindUpload(id, &value, sizeof(value)))
+		glUniform1i(slot->Location, value);
+}
+
+void Shader::SetFloat(UniformId id, GLfloat value) const
+{
+	if (UniformSlot* slot = FindUpload(id, &value, sizeof(value)))
+		glUniform1f(slot->Location, value);
+}
+
+void Shader::SetVec2(UniformId id, const glm::vec2& value) const
+{
+	if (UniformSlot* slot = FindUpload(id, glm::value_ptr(value), sizeof(value)))
+		glUniform2fv(slot->Location, 1, glm::value_ptr(value));
+}
+
+void Shader::SetVec3(UniformId id, const glm::vec3& value) const
+{
+	if (UniformSlot* slot = FindUpload(id, glm::value_ptr(value), sizeof(value)))
+		glUniform3fv(slot->Location, 1, glm::value_ptr(value));
+}
+
+void Shader::SetIVec2(UniformId id, const glm::ivec2& value) const
+{
+	if (UniformSlot* slot = FindUpload(id, glm::value_ptr(value), sizeof(value)))
+		glUniform2iv(slot->Location, 1, glm::value_ptr(value));
+}
+
+void Shader::SetIVec3(UniformId id, const glm::ivec3& value) const
+{
+	if (UniformSlot* slot = FindUpload(id, glm::value_ptr(value), sizeof(value)))
+		glUniform3iv(slot->Location, 1, glm::value_ptr(value));
+}
+
+void Shader::SetVec4(UniformId id, const glm::vec4& value) const
+{
+	if (UniformSlot* slot = FindUpload(id, glm::value_ptr(value), sizeof(value)))
+		glUniform4fv(slot->Location, 1, glm::value_ptr(value));
+}
+
+void Shader::SetMat4(UniformId id, const glm::mat4& value) const
+{
+	if (UniformSlot* slot = FindUpload(id, glm::value_ptr(value), sizeof(value)))
+		glUniformMatrix4fv(slot->Location, 1, GL_FALSE, glm::value_ptr(value));
+}
+
+GLuint Shader::GetUniformBlockIndex(UniformId id) const
+{
+	std::unordered_map<GLuint, BlockSlot>::const_iterator it = m_uniformBlocks.find(id.Hash);
+	return it != m_uniformBlocks.end() ? it->second.Index : GL_INVALID_INDEX;
+}
+
+GLuint Shader::GetStorageBlockIndex(UniformId id) const
+{
+	std::unordered_map<GLuint, GLuint>::const_iterator it = m_storageBlocks.find(id.Hash);
+	return it != m_storageBlocks.end() ? it->second : GL_INVALID_INDEX;
+}
+
+bool Shader::BindUniformBlock(UniformId id, GLuint bindingPoint) const
+{
+	std::unordered_map<GLuint, BlockSlot>::iterator it = m_uniformBlocks.find(id.Hash);
+	if (it == m_uniformBlocks.end())
+		return false;
+
+	if (it->second.Binding != GLint(bindingPoint))
+	{
+		glUniformBlockBinding(Program, it->second.Index, bindingPoint);
+		it->second.Binding = bindingPoint;
+	}
+	return true;
+}
@@ -2,11 +2,37 @@
 
 #include <GL/glew.h>
 #include <chrono>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <glm/fwd.hpp>
 #include "FileWatcher.h"
 typedef std::chrono::system_clock::time_point time_point;
 
 #define DEBUG_SHADER true
 
+// FNV-1a hash of a uniform or block name, used to look up reflected uniforms without strings.
+// Ids of array elements like "Lights[2].Pos" can be built from prefix, index and suffix without allocating.
+struct UniformId
+{
+	constexpr UniformId(const char* name) : Hash(HashString(name, OFFSET_BASIS)) {}
+	explicit UniformId(const std::string& name) : Hash(HashString(name.c_str(), OFFSET_BASIS)) {}
+	UniformId(const char* prefix, int index, const char* suffix = "")
+		: Hash(HashString(suffix, HashChar(HashIndex(HashChar(HashString(prefix, OFFSET_BASIS), '['), index), ']'))) {}
+
+	bool operator==(const UniformId& other) const { return Hash == other.Hash; }
+
+	GLuint Hash;
+
+private:
+	static const GLuint OFFSET_BASIS = 2166136261u;
+	static const GLuint PRIME = 16777619u;
+
+	static constexpr GLuint HashChar(GLuint hash, char c) { return (hash ^ GLuint(static_cast<unsigned char>(c))) * PRIME; }
+	static constexpr GLuint HashString(const char* str, GLuint hash) { return *str ? HashString(str + 1, HashChar(hash, *str)) : hash; }
+	static GLuint HashIndex(GLuint hash, int index) { return index >= 10 ? HashChar(HashIndex(hash, index / 10), '0' + index % 10) : HashChar(hash, '0' + index); }
+};
+
 class Shader
 {
 	struct SourceFile
@@ -33,7 +59,44 @@ public:
 
 	void Test(const char* debugMessage);
 
+	// Reflected at link time, so these never query the driver for names.
+	// Uniforms that are not active in the program are silently ignored, values equal to the last upload are skipped.
+	bool HasUniform(UniformId id) const;
+	GLint GetUniformLocation(UniformId id) const;
+	void SetBool(UniformId id, bool value) const;
+	void SetInt(UniformId id, GLint value) const;
+	void SetFloat(UniformId id, GLfloat value) const;
+	void SetVec2(UniformId id, const glm::vec2& value) const;
+	void SetVec3(UniformId id, const glm::vec3& value) const;
+	void SetIVec2(UniformId id, const glm::ivec2& value) const;
+	void SetIVec3(UniformId id, const glm::ivec3& value) const;
+	void SetVec4(UniformId id, const glm::vec4& value) const;
+	void SetMat4(UniformId id, const glm::mat4& value) const;
+
+	// Uniform and shader storage blocks, GL_INVALID_INDEX if not active
+	GLuint GetUniformBlockIndex(UniformId id) const;
+	GLuint GetStorageBlockIndex(UniformId id) const;
+	bool BindUniformBlock(UniformId id, GLuint bindingPoint) const;
+
 private:
+	struct UniformSlot
+	{
+		GLint Location;
+		GLenum Type;
+		bool HasValue;
+		GLuint Value[16];
+	};
+
+	struct BlockSlot
+	{
+		GLuint Index;
+		GLint Binding;
+	};
+
+	void Reflect();
+	UniformSlot* FindUpload(UniformId id, const void* value, size_t size) const;
+	void AddUniform(const std::string& name, GLint location, GLenum type);
+
 	static void HandleIncludes(std::string& shaderCode, const GLchar* shaderPath);
 	static std::string ReadFile(const GLchar* shaderPath);
 	static GLuint LoadShader(const GLchar* shaderPath, GLenum shaderType, bool& isValid);
@@ -45,4 +108,9 @@ private:
 	GLuint m_transformFeedbackVariablesCount;
 	bool m_isTempValid, m_isValid, m_isDirty;
 
+	mutable std::vector<UniformSlot> m_uniforms;
+	std::unordered_map<GLuint, size_t> m_uniformIndices;
+	mutable std::unordered_map<GLuint, BlockSlot> m_uniformBlocks;
+	std::unordered_map<GLuint, GLuint> m_storageBlocks;
+
 };
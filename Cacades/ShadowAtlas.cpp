@@ -0,0 +1,433 @@
+#include "ShadowAtlas.h"
+#include "Light.h"
+#include "RenderInfo.h"
+#include "Global.h"
+#include "Shader.h"
+#include <algorithm>
+
+// Share of a size class the wanted tile size may leave it by before a light changes its tile size
+static const GLfloat SIZE_HYSTERESIS = 0.25f;
+
+// Tile sizes are powers of two placed along a Z-order curve in cells of the smallest tile. A tile starting
+// at a multiple of its own area along the curve covers a square, aligned block of consecutive cells.
+static GLuint CompactBits(GLuint v)
+{
+	v &= 0x55555555;
+	v = (v ^ (v >> 1)) & 0x33333333;
+	v = (v ^ (v >> 2)) & 0x0F0F0F0F;
+	v = (v ^ (v >> 4)) & 0x00FF00FF;
+	v = (v ^ (v >> 8)) & 0x0000FFFF;
+	return v;
+}
+
+static GLuint SpreadBits(GLuint v)
+{
+	v &= 0x0000FFFF;
+	v = (v | (v << 8)) & 0x00FF00FF;
+	v = (v | (v << 4)) & 0x0F0F0F0F;
+	v = (v | (v << 2)) & 0x33333333;
+	v = (v | (v << 1)) & 0x55555555;
+	return v;
+}
+
+static bool AreCellsFree(const std::vector<bool>& used, GLuint first, GLuint count)
+{
+	for (GLuint cell = first; cell < first + count; ++cell)
+	{
+		if (used[cell])
+			return false;
+	}
+	return true;
+}
+
+static void MarkCells(std::vector<bool>& used, GLuint first, GLuint count, bool value)
+{
+	std::fill(used.begin() + first, used.begin() + first + count, value);
+}
+
+// First aligned block of count free cells along the curve, the cell count if there is none
+static GLuint FindCells(const std::vector<bool>& used, GLuint count)
+{
+	for (GLuint first = 0; first + count <= used.size(); first += count)
+	{
+		if (AreCellsFree(used, first, count))
+			return first;
+	}
+	return GLuint(used.size());
+}
+
+// Marks the cells of tiles if they all still have the requested size and are free
+static bool KeepTiles(const std::vector<ShadowTile>& tiles, GLuint faces, GLsizei size, GLsizei lowTile, GLsizei atlasSize, std::vector<bool>& used)
+{
+	if (size == 0 || tiles.size() != faces)
+		return false;
+
+	GLuint cellsPerTile = (size / lowTile) * (size / lowTile);
+	for (size_t i = 0; i < tiles.size(); ++i)
+	{
+		const ShadowTile& tile = tiles[i];
+		bool valid = tile.Size == size && tile.Offset.x % size == 0 && tile.Offset.y % size == 0 && tile.Offset.x + size <= atlasSize && tile.Offset.y + size <= atlasSize;
+		GLuint first = valid ? SpreadBits(tile.Offset.x / lowTile) | (SpreadBits(tile.Offset.y / lowTile) << 1) : 0;
+		if (!valid || !AreCellsFree(used, first, cellsPerTile))
+		{
+			// Give back the faces marked so far
+			for (size_t j = 0; j < i; ++j)
+				MarkCells(used, SpreadBits(tiles[j].Offset.x / lowTile) | (SpreadBits(tiles[j].Offset.y / lowTile) << 1), cellsPerTile, false);
+			return false;
+		}
+		MarkCells(used, first, cellsPerTile, true);
+	}
+	return true;
+}
+
+static GLsizei FloorPowerOfTwo(GLsizei value)
+{
+	GLsizei power = 1;
+	while (power * 2 <= value)
+		power *= 2;
+	return power;
+}
+
+glm::vec4 ShadowTile::GetRect(GLsizei atlasSize) const
+{
+	return glm::vec4(glm::vec2(Offset), glm::vec2(GLfloat(Size))) / GLfloat(atlasSize);
+}
+
+void ShadowTile::SetViewport() const
+{
+	glViewport(Offset.x, Offset.y, Size, Size);
+}
+
+void ShadowTile::SetViewport(GLuint index) const
+{
+	glViewportIndexedf(index, GLfloat(Offset.x), GLfloat(Offset.y), GLfloat(Size), GLfloat(Size));
+}
+
+ShadowAtlas::ShadowAtlas(GLsizei size) : m_size(size), m_mode(PcfShadows), m_fbo(0), m_depth(0), m_moments(0), m_scratch(0), m_scratchSize(0), m_usedTexels(0)
+{
+	m_blurShader = new Shader("./shaders/ShadowBlur.comp");
+	m_blurShader->Test("ShadowBlur");
+
+	glGenFramebuffers(1, &m_fbo);
+	AllocateTextures();
+}
+
+ShadowAtlas::~ShadowAtlas()
+{
+	DeleteTextures();
+	glDeleteFramebuffers(1, &m_fbo);
+	delete m_blurShader;
+}
+
+void ShadowAtlas::SetShadowMode(ShadowMode mode)
+{
+	bool storageChanged = (mode == VsmShadows) != (m_mode == VsmShadows);
+	m_mode = mode;
+
+	if (storageChanged)
+	{
+		AllocateTextures();
+		return;
+	}
+
+	ConfigureTexture(m_depth, true);
+	if (m_moments != 0)
+		ConfigureTexture(m_moments, false);
+	glCheckError();
+}
+
+void ShadowAtlas::Allocate(const std::vector<Light*>& lights, const glm::mat4& view, const glm::mat4& projection, const RenderInfo& renderInfo, std::vector<Light*>& changed)
+{
+	GLsizei maxTile = glm::min(renderInfo.ShadowMaxTile, m_size);
+	// Blurred moments hold up at a lower resolution
+	if (m_mode == VsmShadows)
+		maxTile = FloorPowerOfTwo(glm::max(GLsizei(maxTile * renderInfo.VsmTileScale), 1));
+	GLsizei lowTile = glm::min(renderInfo.ShadowLowTile, maxTile);
+
+	m_requests.clear();
+	GLuint64 total = 0;
+	for (std::vector<Light*>::const_iterator it = lights.begin(); it != lights.end(); ++it)
+	{
+		Light* light = *it;
+		if (!light->CastsShadows() || !light->IsEnabled())
+			continue;
+
+		Request request;
+		request.Source = light;
+		request.Importance = light->GetShadowImportance(view, projection);
+		request.Faces = light->GetShadowFaceCount();
+		GLfloat wanted;
+		if (request.Importance < renderInfo.ShadowImportanceThreshold)
+		{
+			wanted = GLfloat(lowTile);
+			request.Size = lowTile;
+		}
+		else
+		{
+			wanted = maxTile * glm::sqrt(request.Importance);
+			request.Size = glm::clamp(FloorPowerOfTwo(GLsizei(wanted)), glm::min(2 * lowTile, maxTile), maxTile);
+		}
+
+		// The class of a size holds wanted sizes up to twice of it, a light only leaves its current class
+		// once the wanted size is clearly outside, so it doesn't flip between two sizes and re-render
+		const std::vector<ShadowTile>& current = light->GetShadowTiles();
+		GLsizei previous = current.empty() ? 0 : current[0].Size;
+		if (previous != request.Size && previous >= lowTile && previous <= maxTile && wanted >= previous * (1.0f - SIZE_HYSTERESIS) && wanted < 2.0f * previous * (1.0f + SIZE_HYSTERESIS))
+			request.Size = previous;
+
+		total += GLuint64(request.Faces) * request.Size * request.Size;
+		m_requests.push_back(request);
+	}
+
+	// Halve the largest tiles, least important first, then drop lights until everything fits
+	GLuint64 capacity = GLuint64(m_size) * m_size;
+	while (total > capacity)
+	{
+		Request* shrink = nullptr;
+		Request* drop = nullptr;
+		for (std::vector<Request>::iterator it = m_requests.begin(); it != m_requests.end(); ++it)
+		{
+			if (it->Size > lowTile && (!shrink || it->Size > shrink->Size || (it->Size == shrink->Size && it->Importance < shrink->Importance)))
+				shrink = &*it;
+			if (it->Size > 0 && (!drop || it->Importance < drop->Importance))
+				drop = &*it;
+		}
+
+		Request* request = shrink ? shrink : drop;
+		if (!request)
+			break;
+
+		GLsizei size = shrink ? request->Size / 2 : 0;
+		total -= GLuint64(request->Faces) * (request->Size * request->Size - size * size);
+		request->Size = size;
+	}
+
+	std::stable_sort(m_requests.begin(), m_requests.end(), [](const Request& a, const Request& b) { return a.Size > b.Size; });
+
+	// Lights keep their tiles as long as their size holds, the others are placed into the gaps first fit,
+	// largest first. Cells are indexed along the Z-order curve.
+	GLuint cellsPerSide = GLuint(m_size / lowTile);
+	std::vector<bool> used(cellsPerSide * cellsPerSide, false);
+	std::vector<std::vector<ShadowTile>> placements(m_requests.size());
+	std::vector<bool> kept(m_requests.size(), false);
+	for (size_t i = 0; i < m_requests.size(); ++i)
+	{
+		const Request& request = m_requests[i];
+		kept[i] = KeepTiles(request.Source->GetShadowTiles(), request.Faces, request.Size, lowTile, m_size, used);
+		if (kept[i])
+			placements[i] = request.Source->GetShadowTiles();
+	}
+
+	// Too fragmented to place a tile, start over from an empty atlas where the sorted sizes always fit
+	for (int attempt = 0; attempt < 2; ++attempt)
+	{
+		bool placed = true;
+		for (size_t i = 0; i < m_requests.size() && placed; ++i)
+		{
+			const Request& request = m_requests[i];
+			if (kept[i] || request.Size == 0)
+				continue;
+
+			GLuint cellsPerTile = (request.Size / lowTile) * (request.Size / lowTile);
+			for (GLuint face = 0; face < request.Faces; ++face)
+			{
+				GLuint cell = FindCells(used, cellsPerTile);
+				if (cell == used.size())
+				{
+					placed = false;
+					break;
+				}
+				MarkCells(used, cell, cellsPerTile, true);
+
+				ShadowTile tile;
+				tile.Offset = glm::ivec2(CompactBits(cell), CompactBits(cell >> 1)) * lowTile;
+				tile.Size = request.Size;
+				placements[i].push_back(tile);
+			}
+		}
+		if (placed)
+			break;
+
+		std::fill(used.begin(), used.end(), false);
+		std::fill(kept.begin(), kept.end(), false);
+		for (size_t i = 0; i < placements.size(); ++i)
+			placements[i].clear();
+	}
+
+	m_usedTexels = 0;
+	for (size_t i = 0; i < m_requests.size(); ++i)
+	{
+		const Request& request = m_requests[i];
+		m_usedTexels += GLuint64(placements[i].size()) * request.Size * request.Size;
+		if (placements[i] != request.Source->GetShadowTiles())
+		{
+			request.Source->SetShadowTiles(placements[i], m_size);
+			changed.push_back(request.Source);
+		}
+	}
+
+	// Lights without shadows give their tiles back
+	std::vector<ShadowTile> tiles;
+	for (std::vector<Light*>::const_iterator it = lights.begin(); it != lights.end(); ++it)
+	{
+		if ((!(*it)->CastsShadows() || !(*it)->IsEnabled()) && !(*it)->GetShadowTiles().empty())
+			(*it)->SetShadowTiles(tiles, m_size);
+	}
+}
+
+void ShadowAtlas::Bind(GLuint depthUnit, GLuint momentUnit) const
+{
+	glActiveTexture(GL_TEXTURE0 + depthUnit);
+	glBindTexture(GL_TEXTURE_2D, m_depth);
+	glActiveTexture(GL_TEXTURE0 + momentUnit);
+	glBindTexture(GL_TEXTURE_2D, m_moments);
+	glCheckError();
+}
+
+void ShadowAtlas::BeginRender() const
+{
+	glBindFramebuffer(GL_FRAMEBUFFER, m_fbo);
+	glClearColor(1.0f, 1.0f, 1.0f, 1.0f);
+}
+
+void ShadowAtlas::ClearTile(const ShadowTile& tile) const
+{
+	glEnable(GL_SCISSOR_TEST);
+	glScissor(tile.Offset.x, tile.Offset.y, tile.Size, tile.Size);
+	glClear(GL_DEPTH_BUFFER_BIT | (m_moments != 0 ? GL_COLOR_BUFFER_BIT : 0));
+	glDisable(GL_SCISSOR_TEST);
+	glCheckError();
+}
+
+void ShadowAtlas::EndRender() const
+{
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
+
+void ShadowAtlas::BlurTiles(const std::vector<ShadowTile>& tiles, GLuint faceMask, GLint radius)
+{
+	if (m_moments == 0 || radius <= 0)
+		return;
+
+	m_blurShader->Use();
+	m_blurShader->SetInt("source", 0);
+	m_blurShader->SetInt("radius", radius);
+	glActiveTexture(GL_TEXTURE0);
+
+	for (GLuint face = 0; face < tiles.size(); ++face)
+	{
+		if (!(faceMask & (1u << face)))
+			continue;
+
+		const ShadowTile& tile = tiles[face];
+		if (tile.Size > m_scratchSize)
+		{
+			glDeleteTextures(1, &m_scratch);
+			m_scratchSize = tile.Size;
+			m_scratch = CreateTexture(GL_RG16F, m_scratchSize);
+		}
+
+		GLuint groups = (tile.Size + 7) / 8;
+		m_blurShader->SetInt("tileSize", tile.Size);
+
+		// Rows of the tile into the scratch texture
+		glBindTexture(GL_TEXTURE_2D, m_moments);
+		glBindImageTexture(0, m_scratch, 0, GL_FALSE, 0, GL_WRITE_ONLY, GL_RG16F);
+		m_blurShader->SetIVec2("sourceOffset", tile.Offset);
+		m_blurShader->SetIVec2("targetOffset", glm::ivec2(0));
+		m_blurShader->SetIVec2("direction", glm::ivec2(1, 0));
+		glDispatchCompute(groups, groups, 1);
+		glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT | GL_SHADER_IMAGE_ACCESS_BARRIER_BIT);
+
+		// Columns back into the tile
+		glBindTexture(GL_TEXTURE_2D, m_scratch);
+		glBindImageTexture(0, m_moments, 0, GL_FALSE, 0, GL_WRITE_ONLY, GL_RG16F);
+		m_blurShader->SetIVec2("sourceOffset", glm::ivec2(0));
+		m_blurShader->SetIVec2("targetOffset", tile.Offset);
+		m_blurShader->SetIVec2("direction", glm::ivec2(0, 1));
+		glDispatchCompute(groups, groups, 1);
+		glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT | GL_SHADER_IMAGE_ACCESS_BARRIER_BIT | GL_FRAMEBUFFER_BARRIER_BIT);
+		glCheckError();
+	}
+
+	glBindImageTexture(0, 0, 0, GL_FALSE, 0, GL_WRITE_ONLY, GL_RG16F);
+	glBindTexture(GL_TEXTURE_2D, 0);
+	glUseProgram(0);
+	glCheckError();
+}
+
+GLsizei ShadowAtlas::GetSize() const
+{
+	return m_size;
+}
+
+GLuint64 ShadowAtlas::GetUsedTexels() const
+{
+	return m_usedTexels;
+}
+
+void ShadowAtlas::AllocateTextures()
+{
+	DeleteTextures();
+
+	// Point lights store their linear distance and cascades are fitted tightly, 16 bits are enough
+	m_depth = CreateTexture(GL_DEPTH_COMPONENT16, m_size);
+	ConfigureTexture(m_depth, true);
+	if (m_mode == VsmShadows)
+	{
+		m_moments = CreateTexture(GL_RG16F, m_size);
+		ConfigureTexture(m_moments, false);
+	}
+	glCheckError();
+
+	glBindFramebuffer(GL_FRAMEBUFFER, m_fbo);
+	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, m_moments, 0);
+	glDrawBuffer(m_moments != 0 ? GL_COLOR_ATTACHMENT0 : GL_NONE);
+	glReadBuffer(GL_NONE);
+	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, m_depth, 0);
+	glCheckError();
+
+	glCheckFrameBuffer();
+
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	glCheckError();
+}
+
+void ShadowAtlas::DeleteTextures()
+{
+	glDeleteTextures(1, &m_depth);
+	glDeleteTextures(1, &m_moments);
+	glDeleteTextures(1, &m_scratch);
+	m_depth = 0;
+	m_moments = 0;
+	m_scratch = 0;
+	m_scratchSize = 0;
+}
+
+GLuint ShadowAtlas::CreateTexture(GLenum format, GLsizei size) const
+{
+	GLuint texture;
+	glGenTextures(1, &texture);
+	glBindTexture(GL_TEXTURE_2D, texture);
+	glTexStorage2D(GL_TEXTURE_2D, 1, format, size, size);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	glBindTexture(GL_TEXTURE_2D, 0);
+	glCheckError();
+	return texture;
+}
+
+void ShadowAtlas::ConfigureTexture(GLuint texture, bool isDepth) const
+{
+	// Linear filtering gives PCF a 2x2 comparison per tap and VSM filtered moments.
+	// The depth of VSM shadows is only used for depth testing.
+	bool compare = isDepth && m_mode != VsmShadows;
+	GLint filter = m_mode == HardShadows || (isDepth && !compare) ? GL_NEAREST : GL_LINEAR;
+
+	glBindTexture(GL_TEXTURE_2D, texture);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, filter);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, filter);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_COMPARE_MODE, compare ? GL_COMPARE_REF_TO_TEXTURE : GL_NONE);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_COMPARE_FUNC, GL_LEQUAL);
+	glBindTexture(GL_TEXTURE_2D, 0);
+}
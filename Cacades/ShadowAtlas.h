@@ -0,0 +1,85 @@
+#pragma once
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+#include <vector>
+#include "Enums.h"
+
+class Light;
+class Shader;
+struct RenderInfo;
+
+// Square region of the shadow atlas in texels
+struct ShadowTile
+{
+	glm::ivec2 Offset;
+	GLsizei Size;
+
+	bool operator==(const ShadowTile& other) const
+	{
+		return Offset == other.Offset && Size == other.Size;
+	}
+
+	// Offset and scale in texture coordinates of an atlas with atlasSize texels per side
+	glm::vec4 GetRect(GLsizei atlasSize) const;
+	void SetViewport() const;
+	void SetViewport(GLuint index) const;
+};
+
+// One depth texture holding the shadow maps of all lights, plus an RG16F moments texture for VSM shadows.
+// Every frame each shadow casting light gets a tile per face (cube face, cascade, ...) sized by how much
+// of the view it can affect. Lights below the importance threshold share the smallest tier, and tiles are
+// halved, least important first, until the atlas fits. Lights that still don't fit lose their shadows.
+// Sizes change with some hysteresis and lights keep their tiles while the size holds, so maps are only
+// rendered again when a light actually moves in the atlas.
+// VSM tiles are pre-filtered with a separable compute blur, so they get away with a fraction of the size.
+class ShadowAtlas
+{
+public:
+	explicit ShadowAtlas(GLsizei size);
+	~ShadowAtlas();
+
+	// Reallocates the textures when the storage of the mode differs
+	void SetShadowMode(ShadowMode mode);
+	// Lights whose tiles changed are appended to changed, their shadow maps have to be rendered again
+	// before the new tiles are sampled, since the old content may belong to another light
+	void Allocate(const std::vector<Light*>& lights, const glm::mat4& view, const glm::mat4& projection, const RenderInfo& renderInfo, std::vector<Light*>& changed);
+
+	void Bind(GLuint depthUnit, GLuint momentUnit) const;
+	void BeginRender() const;
+	// Resets depth and moments of the tile only
+	void ClearTile(const ShadowTile& tile) const;
+	void EndRender() const;
+	// Blurs the moments of the tiles selected by faceMask, does nothing unless VSM shadows are used
+	void BlurTiles(const std::vector<ShadowTile>& tiles, GLuint faceMask, GLint radius);
+
+	GLsizei GetSize() const;
+	// Texels handed out by the last allocation
+	GLuint64 GetUsedTexels() const;
+
+protected:
+	struct Request
+	{
+		Light* Source;
+		GLfloat Importance;
+		GLsizei Size;
+		GLuint Faces;
+	};
+
+	void AllocateTextures();
+	void DeleteTextures();
+	GLuint CreateTexture(GLenum format, GLsizei size) const;
+	void ConfigureTexture(GLuint texture, bool isDepth) const;
+
+	GLsizei m_size;
+	ShadowMode m_mode;
+	GLuint m_fbo;
+	GLuint m_depth;
+	// 0 unless VSM shadows are used
+	GLuint m_moments;
+	// Horizontal blur pass of one tile, grows to the largest tile blurred
+	GLuint m_scratch;
+	GLsizei m_scratchSize;
+	Shader* m_blurShader;
+	GLuint64 m_usedTexels;
+	std::vector<Request> m_requests;
+};
@@ -0,0 +1,181 @@
+#include "ShadowScheduler.h"
+#include "Light.h"
+#include "Global.h"
+#include <cmath>
+
+// Distance and angle a light may move before its shadow map is considered stale
+static const float MOVE_EPSILON = 1e-4f;
+static const float ROTATE_EPSILON = 1e-5f;
+// Weight of the newest measurement in the face cost average
+static const float COST_SMOOTHING = 0.1f;
+
+ShadowScheduler::ShadowScheduler() : m_nextLight(0), m_facesPerFrame(2), m_budget(2.0f), m_scheduledFaces(0), m_faceCost(0.0f), m_queryIndex(0)
+{
+	glGenQueries(2, m_queries);
+	m_queryFaces[0] = m_queryFaces[1] = 0;
+	m_queryPending[0] = m_queryPending[1] = false;
+}
+
+ShadowScheduler::~ShadowScheduler()
+{
+	glDeleteQueries(2, m_queries);
+}
+
+void ShadowScheduler::Schedule(const std::vector<Light*>& lights, std::vector<ShadowUpdate>& updates)
+{
+	updates.clear();
+	m_scheduledFaces = 0;
+	ReadTiming();
+
+	for (std::vector<Light*>::const_iterator it = lights.begin(); it != lights.end(); ++it)
+	{
+		LightState& state = m_states[*it];
+		if (!(*it)->CastsShadows() || !(*it)->IsEnabled() || (*it)->GetShadowTiles().empty())
+		{
+			// Nothing kept the map up to date in the meantime
+			state.IsValid = false;
+			continue;
+		}
+
+		glm::vec3 position = (*it)->GetPosition();
+		glm::quat orientation = (*it)->GetOrientation();
+		bool moved = glm::length(position - state.Position) > MOVE_EPSILON || 1.0f - std::abs(glm::dot(orientation, state.Orientation)) > ROTATE_EPSILON;
+		if (!state.IsValid || moved)
+		{
+			GLuint faceCount = (*it)->GetShadowFaceCount();
+			state.PendingFaces = (1u << faceCount) - 1;
+			state.Position = position;
+			state.Orientation = orientation;
+			if (!state.IsValid)
+				state.NextFace = 0;
+			state.IsValid = true;
+		}
+		// The face count may have shrunk since the faces were marked
+		state.PendingFaces |= (*it)->GetStaleFaces();
+		state.PendingFaces &= (1u << (*it)->GetShadowFaceCount()) - 1;
+	}
+
+	// Start at a different light every frame so a budget limited frame doesn't starve the last ones
+	for (size_t n = 0; n < lights.size(); ++n)
+	{
+		Light* light = lights[(m_nextLight + n) % lights.size()];
+		LightState& state = m_states[light];
+		if (!state.IsValid || state.PendingFaces == 0)
+			continue;
+
+		int faceCount = light->GetShadowFaceCount();
+		GLuint mask = 0;
+		if (state.IsRelocated)
+		{
+			for (int face = 0; face < faceCount; ++face)
+			{
+				if (state.PendingFaces & (1u << face))
+					++m_scheduledFaces;
+			}
+			mask = state.PendingFaces;
+			state.PendingFaces = 0;
+			state.IsRelocated = false;
+		}
+
+		for (int i = 0; i < faceCount && i < m_facesPerFrame && state.PendingFaces != 0; ++i)
+		{
+			if (m_scheduledFaces > 0 && (m_scheduledFaces + 1) * m_faceCost > m_budget)
+				break;
+
+			// Next pending face after the last one updated
+			int face = state.NextFace;
+			while (!(state.PendingFaces & (1u << face)))
+				face = (face + 1) % faceCount;
+
+			mask |= 1u << face;
+			state.PendingFaces &= ~(1u << face);
+			state.NextFace = (face + 1) % faceCount;
+			++m_scheduledFaces;
+		}
+
+		if (mask != 0)
+			updates.push_back(ShadowUpdate{ light, mask });
+	}
+
+	if (!lights.empty())
+		m_nextLight = (m_nextLight + 1) % lights.size();
+}
+
+void ShadowScheduler::InvalidateAll()
+{
+	for (std::unordered_map<const Light*, LightState>::iterator it = m_states.begin(); it != m_states.end(); ++it)
+		it->second.IsValid = false;
+}
+
+void ShadowScheduler::Relocate(const Light* light)
+{
+	// Lights without a state yet got their first tiles
+	LightState& state = m_states[light];
+	state.IsValid = false;
+	state.IsRelocated = true;
+}
+
+void ShadowScheduler::BeginTiming()
+{
+	// The query of two frames ago is still in flight, skip measuring this frame
+	if (m_queryPending[m_queryIndex] || m_scheduledFaces == 0)
+		return;
+
+	glBeginQuery(GL_TIME_ELAPSED, m_queries[m_queryIndex]);
+	m_queryFaces[m_queryIndex] = m_scheduledFaces;
+}
+
+void ShadowScheduler::EndTiming()
+{
+	if (m_queryPending[m_queryIndex] || m_scheduledFaces == 0)
+	{
+		m_queryIndex = 1 - m_queryIndex;
+		return;
+	}
+
+	glEndQuery(GL_TIME_ELAPSED);
+	m_queryPending[m_queryIndex] = true;
+	m_queryIndex = 1 - m_queryIndex;
+	glCheckError();
+}
+
+void ShadowScheduler::ReadTiming()
+{
+	for (int i = 0; i < 2; ++i)
+	{
+		if (!m_queryPending[i])
+			continue;
+
+		GLint available = 0;
+		glGetQueryObjectiv(m_queries[i], GL_QUERY_RESULT_AVAILABLE, &available);
+		if (!available)
+			continue;
+
+		GLuint64 elapsed = 0;
+		glGetQueryObjectui64v(m_queries[i], GL_QUERY_RESULT, &elapsed);
+		m_queryPending[i] = false;
+
+		float cost = float(elapsed / 1e6) / m_queryFaces[i];
+		m_faceCost = m_faceCost == 0.0f ? cost : glm::mix(m_faceCost, cost, COST_SMOOTHING);
+	}
+}
+
+void ShadowScheduler::SetFacesPerFrame(int faces)
+{
+	m_facesPerFrame = glm::max(faces, 1);
+}
+
+void ShadowScheduler::SetBudget(float milliseconds)
+{
+	m_budget = milliseconds;
+}
+
+int ShadowScheduler::GetScheduledFaces() const
+{
+	return m_scheduledFaces;
+}
+
+float ShadowScheduler::GetFaceCost() const
+{
+	return m_faceCost;
+}
@@ -0,0 +1,72 @@
+#pragma once
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+#include <unordered_map>
+#include <vector>
+
+class Light;
+
+struct ShadowUpdate
+{
+	Light* Source;
+	// Bit per shadow map face that has to be rendered
+	GLuint FaceMask;
+};
+
+// Decides which shadow maps are re-rendered in a frame.
+// Maps are cached until their light moves, is re-enabled, gets new shadow atlas tiles, the terrain
+// changes or the light reports faces as stale, e.g. cascades that follow the camera. Moving lights with
+// several faces update at most FacesPerFrame of them round-robin, and the whole frame stops adding
+// faces once the measured GPU cost would exceed the budget. At least one face is updated per frame,
+// so every stale map eventually catches up. Lights that got new atlas tiles are rendered completely
+// in the same frame regardless of the budget, their tiles may still hold the maps of other lights.
+class ShadowScheduler
+{
+public:
+	ShadowScheduler();
+	~ShadowScheduler();
+
+	void Schedule(const std::vector<Light*>& lights, std::vector<ShadowUpdate>& updates);
+	// Every map is rendered completely on its next update
+	void InvalidateAll();
+	// The atlas tiles of light changed, all of its faces are rendered in the next Schedule
+	void Relocate(const Light* light);
+
+	// Wrap the rendering of the scheduled updates to measure their GPU cost
+	void BeginTiming();
+	void EndTiming();
+
+	void SetFacesPerFrame(int faces);
+	void SetBudget(float milliseconds);
+
+	int GetScheduledFaces() const;
+	float GetFaceCost() const;
+
+protected:
+	struct LightState
+	{
+		bool IsValid;
+		glm::vec3 Position;
+		glm::quat Orientation;
+		GLuint PendingFaces;
+		int NextFace;
+		// Rendered right away, outside of the budget
+		bool IsRelocated;
+	};
+
+	void ReadTiming();
+
+	std::unordered_map<const Light*, LightState> m_states;
+	size_t m_nextLight;
+	int m_facesPerFrame;
+	float m_budget;
+	int m_scheduledFaces;
+
+	// Exponential moving average of the GPU milliseconds per face
+	float m_faceCost;
+	GLuint m_queries[2];
+	int m_queryFaces[2];
+	bool m_queryPending[2];
+	int m_queryIndex;
+};
@@ -2,7 +2,7 @@
 #include <glm/gtc/type_ptr.hpp>
 #include "Shader.h"
 
-SpotLight::SpotLight(glm::vec3 position, glm::quat orientation, glm::vec3 color, Shader& shadowShader, GLfloat fovy, GLfloat farPlane, GLfloat nearPlane) : DirectionalLight(position, orientation, color, shadowShader, farPlane, nearPlane), m_fovy(fovy)
+SpotLight::SpotLight(glm::vec3 position, glm::quat orientation, glm::vec3 color, Shader& shadowShader, GLfloat fovy, GLfloat farPlane, GLfloat nearPlane) : DirectionalLight(position, orientation, color, shadowShader, 1, farPlane, nearPlane), m_fovy(fovy)
 {
 }
 
@@ -17,8 +17,8 @@ LightType SpotLight::GetType()
 
 glm::mat4 SpotLight::GetProjection() const
 {
-	GLfloat aspect = (GLfloat)SHADOW_WIDTH / (GLfloat)SHADOW_HEIGHT;
-	return  glm::perspective(glm::radians(m_fovy), aspect, m_nearPlane, m_farPlane);
+	// Atlas tiles are square
+	return  glm::perspective(glm::radians(m_fovy), 1.0f, m_nearPlane, m_farPlane);
 }
 
 glm::mat4 SpotLight::GetView() const
@@ -0,0 +1,57 @@
+#include "StageTimer.h"
+#include "Global.h"
+
+StageTimer::StageTimer()
+{
+}
+
+StageTimer::~StageTimer()
+{
+	Clear();
+}
+
+void StageTimer::Begin(const std::string& name)
+{
+	PendingStage stage;
+	stage.Name = name;
+	glGenQueries(2, stage.Queries);
+	glQueryCounter(stage.Queries[0], GL_TIMESTAMP);
+	glCheckError();
+	stage.CpuStart = timerClock::now();
+	stage.CpuEnd = stage.CpuStart;
+	m_stages.push_back(stage);
+}
+
+void StageTimer::End()
+{
+	if (m_stages.empty())
+		return;
+
+	PendingStage& stage = m_stages.back();
+	stage.CpuEnd = timerClock::now();
+	glQueryCounter(stage.Queries[1], GL_TIMESTAMP);
+	glCheckError();
+}
+
+void StageTimer::Resolve(std::vector<StageTiming>& timings)
+{
+	for (std::vector<PendingStage>::const_iterator it = m_stages.begin(); it != m_stages.end(); ++it)
+	{
+		GLuint64 start, end;
+		glGetQueryObjectui64v(it->Queries[0], GL_QUERY_RESULT, &start);
+		glGetQueryObjectui64v(it->Queries[1], GL_QUERY_RESULT, &end);
+		glCheckError();
+
+		double cpu = cr::duration_cast<cr::nanoseconds>(it->CpuEnd - it->CpuStart).count() / 1000000.0;
+		double gpu = (end - start) / 1000000.0;
+		timings.push_back(StageTiming{ it->Name, cpu, gpu });
+	}
+	Clear();
+}
+
+void StageTimer::Clear()
+{
+	for (std::vector<PendingStage>::iterator it = m_stages.begin(); it != m_stages.end(); ++it)
+		glDeleteQueries(2, it->Queries);
+	m_stages.clear();
+}
@@ -0,0 +1,39 @@
+#pragma once
+#include <GL/glew.h>
+#include <string>
+#include <vector>
+#include "Timer.h"
+
+struct StageTiming
+{
+	std::string Name;
+	double CpuMilliseconds;
+	double GpuMilliseconds;
+};
+
+// Records CPU timestamps and GL_TIMESTAMP queries around named stages.
+// Stages may follow each other freely since timestamps, unlike GL_TIME_ELAPSED, do not nest.
+class StageTimer
+{
+public:
+	StageTimer();
+	~StageTimer();
+
+	void Begin(const std::string& name);
+	void End();
+
+	// Blocks until the GPU reached the last timestamp, then moves all recorded stages into timings
+	void Resolve(std::vector<StageTiming>& timings);
+	void Clear();
+
+protected:
+	struct PendingStage
+	{
+		std::string Name;
+		timerClock::time_point CpuStart;
+		timerClock::time_point CpuEnd;
+		GLuint Queries[2];
+	};
+
+	std::vector<PendingStage> m_stages;
+};
@@ -0,0 +1,246 @@
+#include "SurfaceScatter.h"
+#include <glm/gtc/type_ptr.hpp>
+#include <glm/geometric.hpp>
+#include <glm/gtc/constants.hpp>
+#include <algorithm>
+#include <string>
+#include "Global.h"
+#include "Shader.h"
+#include "TriplanarMesh.h"
+
+SurfaceScatter::SurfaceScatter() : m_vao(0), m_vbo(0), m_ibo(0), m_instanceBuffer(0), m_commandBuffer(0), m_isEnabled(true)
+{
+	m_scatterShader = new Shader("./shaders/Scatter.comp");
+	m_scatterShader->Test("Scatter");
+
+	m_rules[RockDecoration] = DecorationRule{ glm::vec2(0.3f, 1.0f), 2.0f, glm::vec2(0.03f, 0.08f), glm::vec3(0.35f, 0.33f, 0.3f) };
+	m_rules[CrystalDecoration] = DecorationRule{ glm::vec2(-0.3f, 0.3f), 0.5f, glm::vec2(0.05f, 0.15f), glm::vec3(0.4f, 0.7f, 0.9f) };
+	m_rules[MossDecoration] = DecorationRule{ glm::vec2(0.7f, 1.0f), 6.0f, glm::vec2(0.05f, 0.12f), glm::vec3(0.2f, 0.4f, 0.1f) };
+
+	SetupMeshes();
+
+	glGenBuffers(1, &m_instanceBuffer);
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_instanceBuffer);
+	glBufferData(GL_SHADER_STORAGE_BUFFER, DECORATION_TYPE_COUNT * MAX_INSTANCES_PER_TYPE * sizeof(glm::mat4), nullptr, GL_DYNAMIC_COPY);
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+	glCheckError();
+
+	glGenBuffers(1, &m_commandBuffer);
+	glBindBuffer(GL_DRAW_INDIRECT_BUFFER, m_commandBuffer);
+	glBufferData(GL_DRAW_INDIRECT_BUFFER, sizeof(m_commands), m_commands, GL_DYNAMIC_DRAW);
+	glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+	glCheckError();
+}
+
+SurfaceScatter::~SurfaceScatter()
+{
+	glDeleteVertexArrays(1, &m_vao);
+	glDeleteBuffers(1, &m_vbo);
+	glDeleteBuffers(1, &m_ibo);
+	glDeleteBuffers(1, &m_instanceBuffer);
+	glDeleteBuffers(1, &m_commandBuffer);
+	delete m_scatterShader;
+}
+
+void SurfaceScatter::SetupMeshes()
+{
+	const glm::vec3 rockVerts[12] = {
+		glm::vec3( 0.000f,  0.000f,  1.000f), glm::vec3( 0.894f,  0.000f,  0.447f),
+		glm::vec3( 0.276f,  0.851f,  0.447f), glm::vec3(-0.724f,  0.526f,  0.447f),
+		glm::vec3(-0.724f, -0.526f,  0.447f), glm::vec3( 0.276f, -0.851f,  0.447f),
+		glm::vec3( 0.724f,  0.526f, -0.447f), glm::vec3(-0.276f,  0.851f, -0.447f),
+		glm::vec3(-0.894f,  0.000f, -0.447f), glm::vec3(-0.276f, -0.851f, -0.447f),
+		glm::vec3( 0.724f, -0.526f, -0.447f), glm::vec3( 0.000f,  0.000f, -1.000f) };
+	const int rockFaces[20 * 3] = {
+		2, 1, 0,	3, 2, 0,	4, 3, 0,	5, 4, 0,	1, 5, 0,
+		11, 6, 7,	11, 7, 8,	11, 8, 9,	11, 9, 10,	11, 10, 6,
+		1, 2, 6,	2, 3, 7,	3, 4, 8,	4, 5, 9,	5, 1, 10,
+		2, 7, 6,	3, 8, 7,	4, 9, 8,	5, 10, 9,	1, 6, 10 };
+
+	// Hexagonal bipyramid growing along the surface normal
+	glm::vec3 crystalVerts[8];
+	crystalVerts[0] = glm::vec3(0, 0, 0);
+	crystalVerts[7] = glm::vec3(0, 1, 0);
+	for (int i = 0; i < 6; ++i)
+	{
+		float angle = glm::two_pi<float>() * i / 6;
+		crystalVerts[1 + i] = glm::vec3(0.15f * cos(angle), 0.6f, 0.15f * sin(angle));
+	}
+	int crystalFaces[12 * 3];
+	for (int i = 0; i < 6; ++i)
+	{
+		int next = 1 + (i + 1) % 6;
+		int faceBottom[3] = { 0, 1 + i, next };
+		int faceTop[3] = { 7, next, 1 + i };
+		std::copy(faceBottom, faceBottom + 3, crystalFaces + i * 6);
+		std::copy(faceTop, faceTop + 3, crystalFaces + i * 6 + 3);
+	}
+
+	// Flat dome lying on the surface
+	glm::vec3 mossVerts[7];
+	mossVerts[0] = glm::vec3(0, 0.05f, 0);
+	for (int i = 0; i < 6; ++i)
+	{
+		float angle = glm::two_pi<float>() * i / 6;
+		mossVerts[1 + i] = glm::vec3(cos(angle), 0, sin(angle));
+	}
+	int mossFaces[6 * 3];
+	for (int i = 0; i < 6; ++i)
+	{
+		mossFaces[i * 3 + 0] = 0;
+		mossFaces[i * 3 + 1] = 1 + (i + 1) % 6;
+		mossFaces[i * 3 + 2] = 1 + i;
+	}
+
+	std::vector<glm::vec3> vertexData;
+	std::vector<GLuint> indices;
+	AddMesh(RockDecoration, rockVerts, rockFaces, 20, glm::vec3(0), vertexData, indices);
+	AddMesh(CrystalDecoration, crystalVerts, crystalFaces, 12, glm::vec3(0, 0.5f, 0), vertexData, indices);
+	AddMesh(MossDecoration, mossVerts, mossFaces, 6, glm::vec3(0, -1, 0), vertexData, indices);
+
+	glGenVertexArrays(1, &m_vao);
+	glGenBuffers(1, &m_vbo);
+	glGenBuffers(1, &m_ibo);
+
+	glBindVertexArray(m_vao);
+	glBindBuffer(GL_ARRAY_BUFFER, m_vbo);
+	glBufferData(GL_ARRAY_BUFFER, vertexData.size() * sizeof(glm::vec3), vertexData.data(), GL_STATIC_DRAW);
+	// Position attribute
+	glEnableVertexAttribArray(VS_IN_POSITION);
+	glVertexAttribPointer(VS_IN_POSITION, 3, GL_FLOAT, GL_FALSE, 2 * sizeof(glm::vec3), (GLvoid*)0);
+	// Normal attribute
+	glEnableVertexAttribArray(VS_IN_NORMAL);
+	glVertexAttribPointer(VS_IN_NORMAL, 3, GL_FLOAT, GL_FALSE, 2 * sizeof(glm::vec3), (GLvoid*)sizeof(glm::vec3));
+
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_ibo);
+	glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(GLuint), indices.data(), GL_STATIC_DRAW);
+	glBindVertexArray(0);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+	glCheckError();
+}
+
+void SurfaceScatter::AddMesh(int type, const glm::vec3* verts, const int* faces, int faceCount, glm::vec3 inside, std::vector<glm::vec3>& vertexData, std::vector<GLuint>& indices)
+{
+	m_commands[type] = DrawElementsIndirectCommand{ GLuint(faceCount * 3), 0, GLuint(indices.size()), 0, 0 };
+
+	// Flat shaded, so every face gets its own vertices
+	for (int i = 0; i < faceCount; ++i)
+	{
+		glm::vec3 a = verts[faces[i * 3 + 0]];
+		glm::vec3 b = verts[faces[i * 3 + 1]];
+		glm::vec3 c = verts[faces[i * 3 + 2]];
+		glm::vec3 normal = glm::normalize(glm::cross(b - a, c - a));
+		if (glm::dot(normal, (a + b + c) / 3.0f - inside) < 0)
+		{
+			std::swap(b, c);
+			normal = -normal;
+		}
+
+		glm::vec3 corners[3] = { a, b, c };
+		for (int j = 0; j < 3; ++j)
+		{
+			indices.push_back(GLuint(vertexData.size() / 2));
+			vertexData.push_back(corners[j]);
+			vertexData.push_back(normal);
+		}
+	}
+}
+
+void SurfaceScatter::Scatter(const TriplanarMesh& mesh, int seed)
+{
+	if (!m_isEnabled)
+		return;
+
+	// Reset the instance counts of the draw commands
+	glBindBuffer(GL_DRAW_INDIRECT_BUFFER, m_commandBuffer);
+	glBufferSubData(GL_DRAW_INDIRECT_BUFFER, 0, sizeof(m_commands), m_commands);
+	glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+	glCheckError();
+
+	m_scatterShader->Use();
+	UpdateUniforms(mesh, seed);
+
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, m_instanceBuffer);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, m_commandBuffer);
+
+	// One invocation per triangle of the whole mesh, the workgroup count was written by the generator
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, mesh.GetVBO());
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 3, mesh.GetCommandBuffer());
+	glBindBuffer(GL_DISPATCH_INDIRECT_BUFFER, mesh.GetCommandBuffer());
+	glDispatchComputeIndirect(0);
+	glBindBuffer(GL_DISPATCH_INDIRECT_BUFFER, 0);
+	glCheckError();
+
+	// Clamp the appended instance counts to the buffer capacity
+	glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+	m_scatterShader->SetInt("finalize", GL_TRUE);
+	glDispatchCompute(1, 1, 1);
+	m_scatterShader->SetInt("finalize", GL_FALSE);
+	glMemoryBarrier(GL_COMMAND_BARRIER_BIT | GL_SHADER_STORAGE_BARRIER_BIT);
+
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, 0);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, 0);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, 0);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 3, 0);
+	glUseProgram(0);
+	glCheckError();
+}
+
+void SurfaceScatter::UpdateUniforms(const TriplanarMesh& mesh, int seed)
+{
+	m_scatterShader->SetMat4("model", mesh.GetMatrix());
+	glCheckError();
+
+	m_scatterShader->SetInt("seed", seed);
+	glCheckError();
+
+	m_scatterShader->SetInt("maxInstances", MAX_INSTANCES_PER_TYPE);
+	glCheckError();
+
+	for (int i = 0; i < DECORATION_TYPE_COUNT; ++i)
+	{
+		m_scatterShader->SetVec2(UniformId("rules", i, ".slopeRange"), m_rules[i].slopeRange);
+		glCheckError();
+
+		m_scatterShader->SetFloat(UniformId("rules", i, ".density"), m_rules[i].density);
+		glCheckError();
+
+		m_scatterShader->SetVec2(UniformId("rules", i, ".scaleRange"), m_rules[i].scaleRange);
+		glCheckError();
+	}
+}
+
+void SurfaceScatter::Render(Shader& shader) const
+{
+	if (!m_isEnabled)
+		return;
+
+	shader.SetInt("maxInstances", MAX_INSTANCES_PER_TYPE);
+	glCheckError();
+
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, m_instanceBuffer);
+	glBindBuffer(GL_DRAW_INDIRECT_BUFFER, m_commandBuffer);
+	glBindVertexArray(m_vao);
+
+	for (int type = 0; type < DECORATION_TYPE_COUNT; ++type)
+	{
+		shader.SetInt("decorationType", type);
+		shader.SetVec3("objectColor", m_rules[type].color);
+		glDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT, (GLvoid*)(type * sizeof(DrawElementsIndirectCommand)));
+		glCheckError();
+	}
+
+	glBindVertexArray(0);
+	glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, 0);
+}
+
+void SurfaceScatter::IsEnabled(bool isEnabled)
+{
+	m_isEnabled = isEnabled;
+}
+
+bool SurfaceScatter::IsEnabled() const
+{
+	return m_isEnabled;
+}
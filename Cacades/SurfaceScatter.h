@@ -0,0 +1,55 @@
+#pragma once
+#include <GL/glew.h>
+#include <glm/detail/type_vec2.hpp>
+#include <glm/detail/type_vec3.hpp>
+#include <vector>
+#include "Enums.h"
+
+class Shader;
+class TriplanarMesh;
+
+struct DrawElementsIndirectCommand
+{
+	GLuint count;
+	GLuint instanceCount;
+	GLuint firstIndex;
+	GLint baseVertex;
+	GLuint baseInstance;
+};
+
+struct DecorationRule
+{
+	glm::vec2 slopeRange;	// accepted range of normal.y
+	float density;			// instances per square world space unit
+	glm::vec2 scaleRange;
+	glm::vec3 color;
+};
+
+class SurfaceScatter
+{
+public:
+	SurfaceScatter();
+	~SurfaceScatter();
+
+	void Scatter(const TriplanarMesh& mesh, int seed);
+	void Render(Shader& shader) const;
+
+	void IsEnabled(bool isEnabled);
+	bool IsEnabled() const;
+
+	static const int MAX_INSTANCES_PER_TYPE = 16384;
+
+protected:
+	void SetupMeshes();
+	void AddMesh(int type, const glm::vec3* verts, const int* faces, int faceCount, glm::vec3 inside, std::vector<glm::vec3>& vertexData, std::vector<GLuint>& indices);
+	void UpdateUniforms(const TriplanarMesh& mesh, int seed);
+
+	Shader* m_scatterShader;
+	GLuint m_vao, m_vbo, m_ibo;
+	GLuint m_instanceBuffer;
+	GLuint m_commandBuffer;
+
+	DrawElementsIndirectCommand m_commands[DECORATION_TYPE_COUNT];
+	DecorationRule m_rules[DECORATION_TYPE_COUNT];
+	bool m_isEnabled;
+};
@@ -30,7 +30,7 @@ Text::~Text()
 
 void Text::Render(Shader& shader) const
 {
-	glUniform3f(glGetUniformLocation(shader.Program, "textColor"), color_.x, color_.y, color_.z);
+	shader.SetVec3("textColor", color_);
 	glActiveTexture(GL_TEXTURE0);
 	glBindVertexArray(vao_);
 
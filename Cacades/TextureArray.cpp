@@ -0,0 +1,104 @@
+#include "TextureArray.h"
+#include <Soil/SOIL.h>
+#include <algorithm>
+#include <cmath>
+#include "Global.h"
+
+TextureArray::TextureArray(const std::vector<const GLchar*>& layerPaths) : m_id(0), m_width(0), m_height(0), m_layerCount(GLsizei(layerPaths.size()))
+{
+	glGenTextures(1, &m_id);
+	glBindTexture(GL_TEXTURE_2D_ARRAY, m_id);
+
+	for (GLint layer = 0; layer < m_layerCount; ++layer)
+	{
+		const GLchar* path = layerPaths[layer];
+		{
+			struct stat buffer;
+			if (stat(path, &buffer) != 0)
+				printf("ERROR::TEXTURE_ARRAY::FILE_NOT_FOUND \"%s\"\n", path);
+		}
+
+		int width = 0, height = 0;
+		unsigned char* image = SOIL_load_image(path, &width, &height, 0, SOIL_LOAD_RGB);
+		if (image == nullptr)
+			continue;
+
+		// The first readable layer decides the size of the whole array
+		if (m_width == 0)
+		{
+			m_width = width;
+			m_height = height;
+			GLsizei levels = GLsizei(std::log2(std::max(m_width, m_height))) + 1;
+			glTexStorage3D(GL_TEXTURE_2D_ARRAY, levels, GL_RGB8, m_width, m_height, m_layerCount);
+			glCheckError();
+		}
+
+		UploadLayer(layer, image, width, height);
+		SOIL_free_image_data(image);
+	}
+
+	if (m_width == 0)
+	{
+		printf("ERROR::TEXTURE_ARRAY::NO_LAYER_LOADED\n");
+		glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+		return;
+	}
+
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_REPEAT);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_REPEAT);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	glGenerateMipmap(GL_TEXTURE_2D_ARRAY);
+	glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+	glCheckError();
+}
+
+TextureArray::~TextureArray()
+{
+	glDeleteTextures(1, &m_id);
+}
+
+void TextureArray::UploadLayer(GLint layer, const unsigned char* image, GLsizei width, GLsizei height)
+{
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+
+	if (width == m_width && height == m_height)
+	{
+		glTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, 0, 0, layer, width, height, 1, GL_RGB, GL_UNSIGNED_BYTE, image);
+		glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+		glCheckError();
+		return;
+	}
+
+	// Let the GPU rescale: upload to a temporary texture and blit it into the layer
+	GLuint source;
+	glGenTextures(1, &source);
+	glBindTexture(GL_TEXTURE_2D, source);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB8, width, height, 0, GL_RGB, GL_UNSIGNED_BYTE, image);
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+
+	GLuint fbos[2];
+	glGenFramebuffers(2, fbos);
+	glBindFramebuffer(GL_READ_FRAMEBUFFER, fbos[0]);
+	glFramebufferTexture2D(GL_READ_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, source, 0);
+	glBindFramebuffer(GL_DRAW_FRAMEBUFFER, fbos[1]);
+	glFramebufferTextureLayer(GL_DRAW_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, m_id, 0, layer);
+	glBlitFramebuffer(0, 0, width, height, 0, 0, m_width, m_height, GL_COLOR_BUFFER_BIT, GL_LINEAR);
+
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	glDeleteFramebuffers(2, fbos);
+	glBindTexture(GL_TEXTURE_2D, 0);
+	glDeleteTextures(1, &source);
+	glBindTexture(GL_TEXTURE_2D_ARRAY, m_id);
+	glCheckError();
+}
+
+GLuint TextureArray::GetId() const
+{
+	return m_id;
+}
+
+GLsizei TextureArray::GetLayerCount() const
+{
+	return m_layerCount;
+}
@@ -0,0 +1,22 @@
+#pragma once
+#include <GL/glew.h>
+#include <vector>
+
+// GL_TEXTURE_2D_ARRAY with one image file per layer.
+// Layers of a different size are scaled to the size of the first one on upload.
+class TextureArray
+{
+public:
+	explicit TextureArray(const std::vector<const GLchar*>& layerPaths);
+	~TextureArray();
+
+	GLuint GetId() const;
+	GLsizei GetLayerCount() const;
+
+private:
+	void UploadLayer(GLint layer, const unsigned char* image, GLsizei width, GLsizei height);
+
+	GLuint m_id;
+	GLsizei m_width, m_height;
+	GLsizei m_layerCount;
+};
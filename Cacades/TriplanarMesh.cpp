@@ -4,129 +4,272 @@
 #include "Shader.h"
 
 
-TriplanarMesh::TriplanarMesh() : BaseObject(glm::vec3(0)), m_triCount(nullptr), m_vaoCount(64), m_colorMode(ColorBlendMode::ColorOnly), m_normalMode(NormalBlendMode::NormalsOnly), m_texture(nullptr), m_normalMap(nullptr), m_displacementMap(nullptr)
+TriplanarMesh::TriplanarMesh() : BaseObject(glm::vec3(0)), m_vbo(0), m_vao(0), m_commandBuffer(0), m_boundsBuffer(0), m_visibilityBuffer(0), m_triangleCapacity(0), m_colorMode(ColorBlendMode::ColorOnly), m_normalMode(NormalBlendMode::NormalsOnly), m_albedoMaps(nullptr), m_normalMaps(nullptr), m_heightMaps(nullptr), m_projectionMaterials(0)
 {
 	m_color = glm::vec3(1);
 
-	m_triCount = new GLsizei[m_vaoCount];
+	for (int i = 0; i < SLAB_COUNT; ++i)
+		m_boundsMin[i] = m_boundsMax[i] = glm::vec3(0);
 
-	m_vao = new GLuint[m_vaoCount];
-	glGenVertexArrays(m_vaoCount, m_vao);
-	m_vbo = new GLuint[m_vaoCount];
-	glGenBuffers(m_vaoCount, m_vbo);
+	glGenVertexArrays(1, &m_vao);
+	glGenBuffers(1, &m_vbo);
 
-	for (int i = 0; i < m_vaoCount; ++i)
-	{
-		glBindVertexArray(m_vao[i]);
+	glBindVertexArray(m_vao);
+	glBindBuffer(GL_ARRAY_BUFFER, m_vbo);
+	glCheckError();
+	// Position attribute
+	glEnableVertexAttribArray(VS_IN_POSITION);
+	glVertexAttribPointer(VS_IN_POSITION, 3, GL_FLOAT, GL_FALSE, sizeof(glm::vec3) * 3, (GLvoid*)0);
+	glEnableVertexAttribArray(VS_IN_NORMAL);
+	glVertexAttribPointer(VS_IN_NORMAL, 3, GL_FLOAT, GL_FALSE, sizeof(glm::vec3) * 3, (GLvoid*)sizeof(glm::vec3));
+	glEnableVertexAttribArray(VS_IN_UV);
+	glVertexAttribPointer(VS_IN_UV, 3, GL_FLOAT, GL_FALSE, sizeof(glm::vec3) * 3, (GLvoid*)(2 * sizeof(glm::vec3)));
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+	glBindVertexArray(0);
+	glCheckError();
 
-		glBindBuffer(GL_ARRAY_BUFFER, m_vbo[i]);
-		//glBufferData(GL_ARRAY_BUFFER, m_triCount[i] * 3 * sizeof(glm::vec3) * 2, nullptr, GL_STATIC_DRAW);
-		glCheckError();
-		// Position attribute
-		glEnableVertexAttribArray(VS_IN_POSITION);
-		glVertexAttribPointer(VS_IN_POSITION, 3, GL_FLOAT, GL_FALSE, sizeof(glm::vec3) * 3, (GLvoid*)0);
-		glEnableVertexAttribArray(VS_IN_NORMAL);
-		glVertexAttribPointer(VS_IN_NORMAL, 3, GL_FLOAT, GL_FALSE, sizeof(glm::vec3) * 3, (GLvoid*)sizeof(glm::vec3));
-		glEnableVertexAttribArray(VS_IN_UV);
-		glVertexAttribPointer(VS_IN_UV, 3, GL_FLOAT, GL_FALSE, sizeof(glm::vec3) * 3, (GLvoid*)(2 * sizeof(glm::vec3)));
-		glBindBuffer(GL_ARRAY_BUFFER, 0);
-		glCheckError();
-		glBindVertexArray(0);
-	}
+	// Empty commands until the first mesh is generated
+	std::vector<GLubyte> zeros(GetCommandOffset(SLAB_COUNT), 0);
+	glGenBuffers(1, &m_commandBuffer);
+	glBindBuffer(GL_DRAW_INDIRECT_BUFFER, m_commandBuffer);
+	glBufferData(GL_DRAW_INDIRECT_BUFFER, zeros.size(), zeros.data(), GL_DYNAMIC_COPY);
+	glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+	glCheckError();
+
+	glGenBuffers(1, &m_boundsBuffer);
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_boundsBuffer);
+	glBufferData(GL_SHADER_STORAGE_BUFFER, SLAB_COUNT * 2 * sizeof(glm::vec4), nullptr, GL_DYNAMIC_COPY);
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+	glCheckError();
+
+	// Nothing is known to be visible before the first occlusion test
+	glGenBuffers(1, &m_visibilityBuffer);
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_visibilityBuffer);
+	glBufferData(GL_SHADER_STORAGE_BUFFER, SLAB_COUNT * sizeof(GLuint), zeros.data(), GL_DYNAMIC_COPY);
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+	glCheckError();
 
-	m_texture = new Texture[3]{ Texture("textures/floor_d.jpg"), Texture("textures/floor_d.jpg") , Texture("textures/floor_d.jpg") };
-	m_normalMap = new Texture[3]{ Texture("textures/floor_n.jpg"), Texture("textures/floor_n.jpg") , Texture("textures/floor_n.jpg") };
-	m_displacementMap = new Texture[3]{ Texture("textures/floor_h.jpg"), Texture("textures/floor_h.jpg") , Texture("textures/floor_h.jpg") };
-	//m_texture = new Texture[3] {Texture("textures/grass01.png"), Texture("textures/grass02.png") , Texture("textures/grass03.png") };
-	//m_normalMap = new Texture[3] {Texture("textures/grass01_n.png"), Texture("textures/grass02_n.png") , Texture("textures/grass03_n.png") };
-	//m_displacementMap = new Texture[3] {Texture("textures/grass01_h.png"), Texture("textures/grass02_h.png") , Texture("textures/grass03_h.png") };
+	// One layer per terrain material, selected per projection by m_projectionMaterials
+	m_albedoMaps = new TextureArray({ "textures/floor_d.jpg", "textures/bricks_d.jpg", "textures/grass01.png" });
+	m_normalMaps = new TextureArray({ "textures/floor_n.jpg", "textures/bricks_n.jpg", "textures/grass01_n.png" });
+	m_heightMaps = new TextureArray({ "textures/floor_h.jpg", "textures/bricks_h.jpg", "textures/grass01_h.png" });
+
+	m_material.Target = GL_TEXTURE_2D_ARRAY;
+	m_material.Textures[0] = m_albedoMaps->GetId();
+	m_material.Textures[1] = m_normalMaps->GetId();
+	m_material.Textures[2] = m_heightMaps->GetId();
 }
 
 
 TriplanarMesh::~TriplanarMesh()
 {
-	glDeleteVertexArrays(m_vaoCount, m_vao);
-	glDeleteBuffers(m_vaoCount, m_vbo);
+	glDeleteVertexArrays(1, &m_vao);
+	glDeleteBuffers(1, &m_vbo);
+	glDeleteBuffers(1, &m_commandBuffer);
+	glDeleteBuffers(1, &m_boundsBuffer);
+	glDeleteBuffers(1, &m_visibilityBuffer);
+	delete m_albedoMaps;
+	delete m_normalMaps;
+	delete m_heightMaps;
 }
 
-GLuint TriplanarMesh::GetVAO(int index) const
+void TriplanarMesh::Reserve(GLsizeiptr triangleCapacity)
 {
-	return m_vao[index];
+	if (triangleCapacity == m_triangleCapacity)
+		return;
+
+	m_triangleCapacity = triangleCapacity;
+	glBindBuffer(GL_ARRAY_BUFFER, m_vbo);
+	glBufferData(GL_ARRAY_BUFFER, m_triangleCapacity * 3 * (sizeof(glm::vec3) * 3), nullptr, GL_STATIC_COPY);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+	glCheckError();
 }
 
-GLuint TriplanarMesh::GetVBO(int index) const
+GLsizeiptr TriplanarMesh::GetTriangleCapacity() const
 {
-	return m_vbo[index];
+	return m_triangleCapacity;
 }
 
-void TriplanarMesh::UpdateVao(int index, int triCount)
+GLuint TriplanarMesh::GetVAO() const
 {
-	m_triCount[index] = triCount;
+	return m_vao;
 }
 
-void TriplanarMesh::Update(GLfloat deltaTime)
+GLuint TriplanarMesh::GetVBO() const
 {
+	return m_vbo;
 }
 
-void TriplanarMesh::Render(Shader& shader, bool tesselate) const
+GLuint TriplanarMesh::GetCommandBuffer() const
 {
-	GLint modelLoc = glGetUniformLocation(shader.Program, "model");
-	glUniformMatrix4fv(modelLoc, 1, GL_FALSE, glm::value_ptr(GetMatrix()));
-	glCheckError();
+	return m_commandBuffer;
+}
 
-	GLint colorModeLoc = glGetUniformLocation(shader.Program, "colorMode");
-	glUniform1i(colorModeLoc, m_colorMode);
-	glCheckError();
+GLuint TriplanarMesh::GetBoundsBuffer() const
+{
+	return m_boundsBuffer;
+}
 
-	GLint objectColorLoc = glGetUniformLocation(shader.Program, "objectColor");
-	glUniform3fv(objectColorLoc, 1, glm::value_ptr(m_color));
-	glCheckError();
+GLuint TriplanarMesh::GetVisibilityBuffer() const
+{
+	return m_visibilityBuffer;
+}
+
+GLintptr TriplanarMesh::GetCommandOffset(int slab)
+{
+	return sizeof(SlabDrawHeader) + slab * sizeof(DrawArraysIndirectCommand);
+}
+
+void TriplanarMesh::SetSlabBounds(int slab, glm::vec3 boundsMin, glm::vec3 boundsMax)
+{
+	m_boundsMin[slab] = boundsMin;
+	m_boundsMax[slab] = boundsMax;
+}
+
+GLuint TriplanarMesh::GetSlabCount() const
+{
+	return SLAB_COUNT;
+}
 
-	GLint normalModeLoc = glGetUniformLocation(shader.Program, "normalMode");
-	glUniform1i(normalModeLoc, m_normalMode);
+void TriplanarMesh::ReadCommands(SlabDrawHeader& header, std::vector<DrawArraysIndirectCommand>& commands) const
+{
+	commands.resize(SLAB_COUNT);
+	glMemoryBarrier(GL_BUFFER_UPDATE_BARRIER_BIT);
+	glBindBuffer(GL_COPY_READ_BUFFER, m_commandBuffer);
+	glGetBufferSubData(GL_COPY_READ_BUFFER, 0, sizeof(header), &header);
+	glGetBufferSubData(GL_COPY_READ_BUFFER, GetCommandOffset(0), SLAB_COUNT * sizeof(DrawArraysIndirectCommand), commands.data());
+	glBindBuffer(GL_COPY_READ_BUFFER, 0);
 	glCheckError();
+}
+
+void TriplanarMesh::Update(GLfloat deltaTime)
+{
+}
+
+void TriplanarMesh::Render(Shader& shader, bool tesselate) const
+{
+	SetDrawUniforms(shader);
 
 	for (int i = 0; i < 3; ++i)
 	{
-		int textureLoc = glGetUniformLocation(shader.Program, ("objectTexture[" + std::to_string(i) + "]").c_str());
-		glActiveTexture(GL_TEXTURE1 + i * 3);
-		glBindTexture(GL_TEXTURE_2D, m_texture[i].GetId());
-		glUniform1i(textureLoc, 1 + i * 3);
-		glCheckError();
-		int normalLoc = glGetUniformLocation(shader.Program, ("normalMap[" + std::to_string(i) + "]").c_str());
-		glActiveTexture(GL_TEXTURE2 + i * 3);
-		glBindTexture(GL_TEXTURE_2D, m_texture[i].GetId());
-		glUniform1i(normalLoc, 2 + i * 3);
-		glCheckError();
-		int displacementLoc = glGetUniformLocation(shader.Program, ("displacementMap[" + std::to_string(i) + "]").c_str());
-		glActiveTexture(GL_TEXTURE3 + i * 3);
-		glBindTexture(GL_TEXTURE_2D, m_texture[i].GetId());
-		glUniform1i(displacementLoc, 3 + i * 3);
+		glActiveTexture(GL_TEXTURE0 + Material::FIRST_UNIT + i);
+		glBindTexture(GL_TEXTURE_2D_ARRAY, m_material.Textures[i]);
 		glCheckError();
 	}
 
-	for (int i = 0; i < m_vaoCount; ++i)
+	glBindVertexArray(m_vao);
+	glBindBuffer(GL_DRAW_INDIRECT_BUFFER, m_commandBuffer);
+	if (tesselate)
+		glPatchParameteri(GL_PATCH_VERTICES, 3);
+	glMultiDrawArraysIndirect(tesselate ? GL_PATCHES : GL_TRIANGLES, (GLvoid*)GetCommandOffset(0), SLAB_COUNT, 0);
+	glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+	glBindVertexArray(0);
+	glCheckError();
+}
+
+DrawPacket TriplanarMesh::MakePacket(int first, int last) const
+{
+	DrawPacket packet;
+	packet.Object = this;
+	packet.Vao = m_vao;
+	packet.PatchVertices = 3;
+	// All slabs share the position of the mesh, so the distance says nothing about their order
+	packet.HasPosition = false;
+	packet.IndirectBuffer = m_commandBuffer;
+	packet.IndirectOffset = GetCommandOffset(first);
+	packet.Count = last - first;
+	packet.BoundsBuffer = m_boundsBuffer;
+	packet.BoundsFirst = first;
+	packet.VisibilityBuffer = m_visibilityBuffer;
+
+	glm::mat4 model = GetMatrix();
+	packet.HasBounds = true;
+	Frustum::TransformBounds(model, m_boundsMin[first], m_boundsMax[first], packet.BoundsMin, packet.BoundsMax);
+	for (int i = first + 1; i < last; ++i)
 	{
-		glBindVertexArray(m_vao[i]);
-		glCheckError();
-		if (tesselate)
-		{
-			glPatchParameteri(GL_PATCH_VERTICES, 3);
-			glDrawArrays(GL_PATCHES, 0, m_triCount[i] * 3);
-		}
-		else
-			glDrawArrays(GL_TRIANGLES, 0, m_triCount[i] * 3);
-		glCheckError();
-		glBindVertexArray(0);
+		glm::vec3 boundsMin, boundsMax;
+		Frustum::TransformBounds(model, m_boundsMin[i], m_boundsMax[i], boundsMin, boundsMax);
+		packet.BoundsMin = glm::min(packet.BoundsMin, boundsMin);
+		packet.BoundsMax = glm::max(packet.BoundsMax, boundsMax);
 	}
+	return packet;
+}
+
+void TriplanarMesh::Submit(RenderQueue& queue, RenderPass pass, Shader& shader) const
+{
+	DrawPacket packet = MakePacket(0, SLAB_COUNT);
+	packet.Program = &shader;
+	packet.Surface = pass == OpaquePass ? &m_material : nullptr;
+	packet.Mode = pass == ShadowPass ? GL_TRIANGLES : GL_PATCHES;
+	packet.CullFace = pass == ShadowPass;
+	queue.Submit(pass, packet);
+}
+
+void TriplanarMesh::Submit(RenderQueue& queue, RenderPass pass, Shader& patchShader, Shader& flatShader, GLfloat tessDistance) const
+{
+	glm::vec3 viewPos = queue.GetViewPosition();
+	glm::mat4 model = GetMatrix();
+
+	bool tessellate[SLAB_COUNT];
+	for (int i = 0; i < SLAB_COUNT; ++i)
+	{
+		glm::vec3 boundsMin, boundsMax;
+		Frustum::TransformBounds(model, m_boundsMin[i], m_boundsMax[i], boundsMin, boundsMax);
+
+		// Distance to the closest point of the bounds
+		glm::vec3 offset = glm::max(glm::max(boundsMin - viewPos, viewPos - boundsMax), glm::vec3(0));
+		tessellate[i] = glm::dot(offset, offset) < tessDistance * tessDistance;
+	}
+
+	for (int first = 0; first < SLAB_COUNT;)
+	{
+		int last = first + 1;
+		while (last < SLAB_COUNT && tessellate[last] == tessellate[first])
+			++last;
+
+		DrawPacket packet = MakePacket(first, last);
+		packet.Program = tessellate[first] ? &patchShader : &flatShader;
+		packet.Surface = pass == OpaquePass ? &m_material : nullptr;
+		packet.Mode = tessellate[first] ? GL_PATCHES : GL_TRIANGLES;
+		queue.Submit(pass, packet);
+		first = last;
+	}
+}
+
+void TriplanarMesh::SetDrawUniforms(const Shader& shader) const
+{
+	shader.SetMat4("model", GetMatrix());
+	glCheckError();
+
+	shader.SetInt("colorMode", m_colorMode);
+	glCheckError();
+
+	shader.SetVec3("objectColor", m_color);
+	glCheckError();
+
+	shader.SetInt("normalMode", m_normalMode);
+	glCheckError();
+
+	shader.SetInt("albedoMaps", Material::FIRST_UNIT);
+	shader.SetInt("normalMaps", Material::FIRST_UNIT + 1);
+	shader.SetInt("heightMaps", Material::FIRST_UNIT + 2);
+	glCheckError();
+
+	shader.SetIVec3("projectionMaterials", m_projectionMaterials);
+	glCheckError();
+}
+
+void TriplanarMesh::SetProjectionMaterials(glm::ivec3 materials)
+{
+	m_projectionMaterials = glm::clamp(materials, glm::ivec3(0), glm::ivec3(GetMaterialCount() - 1));
 }
 
-GLsizei TriplanarMesh::GetTriCount(int index) const
+glm::ivec3 TriplanarMesh::GetProjectionMaterials() const
 {
-	return m_triCount[index];
+	return m_projectionMaterials;
 }
 
-GLuint TriplanarMesh::GetVaoCount() const
+GLsizei TriplanarMesh::GetMaterialCount() const
 {
-	return m_vaoCount;
+	return m_albedoMaps->GetLayerCount();
 }
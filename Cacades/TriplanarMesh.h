@@ -1,36 +1,91 @@
 #pragma once
 #include <GL/glew.h>
-#include "Texture.h"
+#include "TextureArray.h"
 #include "Enums.h"
 #include <glm/detail/type_vec3.hpp>
 #include "BaseObject.h"
+#include "RenderQueue.h"
+#include <vector>
 
+// Layout consumed by glMultiDrawArraysIndirect
+struct DrawArraysIndirectCommand
+{
+	GLuint count;
+	GLuint instanceCount;
+	GLuint first;
+	GLuint baseInstance;
+};
+
+// Start of the command buffer, followed by one DrawArraysIndirectCommand per slab
+struct SlabDrawHeader
+{
+	// Indirect dispatch with one invocation per triangle in workgroups of 64
+	GLuint Dispatch[3];
+	GLuint TriangleCount;
+};
+
+// Marching cubes surface, all slabs share one vertex buffer and are drawn with one indirect multi-draw.
+// The generator writes the triangle count of every slab into its command through a query buffer and
+// shaders/SlabCommands.comp turns the counts into draw commands, so nothing is read back for rendering.
 class TriplanarMesh : public BaseObject
 {
 public:
 	TriplanarMesh();
 	~TriplanarMesh();
 
-	GLuint GetVAO(int index) const;
-	GLuint GetVBO(int index) const;
-	void UpdateVao(int index, int triCount);
+	// Reallocates the vertex buffer for up to triangleCapacity triangles of all slabs together
+	void Reserve(GLsizeiptr triangleCapacity);
+	GLsizeiptr GetTriangleCapacity() const;
+
+	GLuint GetVAO() const;
+	GLuint GetVBO() const;
+	GLuint GetCommandBuffer() const;
+	static GLintptr GetCommandOffset(int slab);
+	// Tight object space min and max (two vec4) per slab, measured on the GPU by the generator. Lets the
+	// render queue cull every slab of a packet against the camera and light frustums.
+	GLuint GetBoundsBuffer() const;
+	// One uint per slab, whether the last occlusion test of the render queue found it visible
+	GLuint GetVisibilityBuffer() const;
+	// Conservative object space bounds of a slab, used for level of detail and to cull whole packets
+	void SetSlabBounds(int slab, glm::vec3 boundsMin, glm::vec3 boundsMax);
+	GLuint GetSlabCount() const;
+	// Blocking read back of the slab commands, meant for exports and statistics only
+	void ReadCommands(SlabDrawHeader& header, std::vector<DrawArraysIndirectCommand>& commands) const;
 
 	void Update(GLfloat deltaTime) override;
 	void Render(Shader& shader, bool tesselate) const;
+	// Opaque and depth packets are tessellated patches, shadow packets plain triangles
+	void Submit(RenderQueue& queue, RenderPass pass, Shader& shader) const override;
+	// Slabs within tessDistance of the view are tessellated patches of patchShader, farther slabs plain
+	// triangles of flatShader. Consecutive slabs of the same kind share one multi-draw.
+	void Submit(RenderQueue& queue, RenderPass pass, Shader& patchShader, Shader& flatShader, GLfloat tessDistance) const;
+	void SetDrawUniforms(const Shader& shader) const override;
+
+	// Material layer used by the x, y and z projection
+	void SetProjectionMaterials(glm::ivec3 materials);
+	glm::ivec3 GetProjectionMaterials() const;
+	GLsizei GetMaterialCount() const;
 
-	GLsizei GetTriCount(int index) const;
-	GLuint GetVaoCount() const;
+	static const int SLAB_COUNT = 64;
 
 private:
-	GLuint* m_vbo;
-	GLuint* m_vao;
-	GLsizei* m_triCount;
-	GLuint m_vaoCount;
+	// Multi-draw of the slabs [first, last) with the union of their bounds
+	DrawPacket MakePacket(int first, int last) const;
+
+	GLuint m_vbo;
+	GLuint m_vao;
+	GLuint m_commandBuffer;
+	GLuint m_boundsBuffer;
+	GLuint m_visibilityBuffer;
+	GLsizeiptr m_triangleCapacity;
+	glm::vec3 m_boundsMin[SLAB_COUNT];
+	glm::vec3 m_boundsMax[SLAB_COUNT];
 	glm::vec3 m_color;
 	ColorBlendMode m_colorMode;
 	NormalBlendMode m_normalMode;
-	Texture* m_texture;
-	Texture* m_normalMap;
-	Texture* m_displacementMap;
+	TextureArray* m_albedoMaps;
+	TextureArray* m_normalMaps;
+	TextureArray* m_heightMaps;
+	glm::ivec3 m_projectionMaterials;
+	Material m_material;
 };
-
@@ -6,6 +6,7 @@
 #include "Hud.h"
 #include "PointLight.h"
 #include "DirectionalLight.h"
+#include "LightSwarm.h"
 #include "LinearPath.h"
 
 #define CPP true
@@ -115,6 +116,10 @@ int main(int argc, char** argv)
 		antiLight1->IsEnabled(true);
 		engine->AddLight(*antiLight1);
 
+		// Toggled with F11
+		LightSwarm* swarm = new LightSwarm(*pointLightShader, 256, 3.0f, 0);
+		engine->AddLightSwarm(*swarm);
+
 		engine->Start();
 
 		return 0;
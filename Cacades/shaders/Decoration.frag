@@ -0,0 +1,36 @@
+#version 430 core
+
+out vec4 FragColor;
+
+#pragma include "EnumLightType.glh"
+#pragma include "EnumShadowMode.glh"
+#pragma include "EnumPointShadowMode.glh"
+#pragma include "FrameData.glh"
+#pragma include "Lighting.glh"
+
+in VS_OUT
+{
+	vec3 FragPos;
+	vec3 Normal;
+} fs_in;
+
+uniform bool EnableLighting = true;
+uniform vec3 objectColor = vec3(1);
+
+void main()
+{
+	if (!EnableLighting)
+	{
+		FragColor = vec4(objectColor, 1.0f);
+		return;
+	}
+
+	LightingGlobals globals = LightingGlobals(viewPos, fs_in.FragPos, normalize(fs_in.Normal), EnableLighting);
+
+	vec3 lighting = CalculateLightSources(globals);
+
+	lighting = clamp(lighting, 0, 1);
+	lighting *= objectColor;
+
+	FragColor = vec4(lighting, 1.0f);
+}
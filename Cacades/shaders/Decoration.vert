@@ -0,0 +1,28 @@
+#version 430 core
+layout(location = 0) in vec3 position;
+layout(location = 1) in vec3 normal;
+
+layout(std430, binding = 1) readonly buffer Instances
+{
+	mat4 instances[];
+};
+
+out VS_OUT
+{
+	vec3 FragPos;
+	vec3 Normal;
+} vs_out;
+
+#pragma include "FrameData.glh"
+
+uniform int decorationType;
+uniform int maxInstances;
+
+void main()
+{
+	mat4 model = instances[decorationType * maxInstances + gl_InstanceID];
+
+	vs_out.FragPos = vec3(model * vec4(position, 1.0f));
+	vs_out.Normal = normalize(mat3(transpose(inverse(model))) * normal);
+	gl_Position = projection * view * vec4(vs_out.FragPos, 1.0f);
+}
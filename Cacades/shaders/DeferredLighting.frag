@@ -0,0 +1,47 @@
+#version 430 core
+
+layout(location = 0) out vec4 FragColor;
+
+#pragma include "EnumLightType.glh"
+#pragma include "EnumShadowMode.glh"
+#pragma include "EnumPointShadowMode.glh"
+#pragma include "FrameData.glh"
+#pragma include "Lighting.glh"
+
+uniform sampler2D gAlbedo;
+uniform sampler2D gNormal;
+uniform sampler2D gDepth;
+uniform mat4 inverseViewProjection;
+
+// Shades every pixel the G-buffer pass covered once, no matter how often it was overdrawn
+void main()
+{
+	ivec2 texel = ivec2(gl_FragCoord.xy);
+	float depth = texelFetch(gDepth, texel, 0).r;
+	if (depth == 1.0f)
+		discard;
+
+	// Later forward passes depth test against the scene
+	gl_FragDepth = depth;
+
+	vec4 albedo = texelFetch(gAlbedo, texel, 0);
+	if (albedo.a == 0.0f)
+	{
+		FragColor = vec4(albedo.rgb, 1.0f);
+		return;
+	}
+
+	// The G-buffer may be larger than the scaled viewport
+	vec2 ndc = (vec2(texel) + 0.5f) / ViewportSize * 2.0f - 1.0f;
+	vec4 position = inverseViewProjection * vec4(ndc, depth * 2.0f - 1.0f, 1.0f);
+	vec3 normal = texelFetch(gNormal, texel, 0).xyz;
+
+	LightingGlobals globals = LightingGlobals(viewPos, position.xyz / position.w, normal, true);
+
+	vec3 lighting = CalculateLightSources(globals);
+
+	lighting = clamp(lighting, 0, 1);
+	lighting *= albedo.rgb;
+
+	FragColor = vec4(lighting, 1.0f);
+}
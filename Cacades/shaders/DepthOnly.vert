@@ -0,0 +1,13 @@
+#version 430 core
+layout(location = 0) in vec3 position;
+
+uniform mat4 model;
+#pragma include "FrameData.glh"
+
+// Must match default.vert and TriPlanarFlat.vert bit for bit, the main pass tests with GL_EQUAL
+invariant gl_Position;
+
+void main()
+{
+	gl_Position = projection * view *  model * vec4(position, 1.0f);
+}
@@ -0,0 +1,13 @@
+#version 430 core
+layout(location = 0) in vec3 position;
+layout(location = 1) in vec3 normal;
+
+out vec3 vs_Normal;
+
+uniform mat4 model;
+
+void main()
+{
+	gl_Position	= model * vec4(position, 1.0f);
+	vs_Normal = normalize(vec3(transpose(inverse(model)) * vec4(normal, 1.0f)));
+}
@@ -0,0 +1,8 @@
+#version 430 core
+
+// Fullscreen triangle, no vertex buffer needed
+void main()
+{
+	vec2 position = vec2((gl_VertexID & 1) * 4.0f - 1.0f, (gl_VertexID & 2) * 2.0f - 1.0f);
+	gl_Position = vec4(position, 0.0f, 1.0f);
+}
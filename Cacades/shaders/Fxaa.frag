@@ -0,0 +1,155 @@
+#version 430 core
+
+out vec4 FragColor;
+
+uniform sampler2D source;
+uniform vec2 inverseSourceSize;
+uniform vec2 inverseTargetSize;
+// Part of the source covered by the rendered viewport
+uniform vec2 sourceScale = vec2(1.0f);
+// Without it the source is only filtered to the target size
+uniform bool antiAliasing = true;
+
+// Edges with less local contrast are left alone
+const float EDGE_THRESHOLD = 0.125f;
+const float EDGE_THRESHOLD_MIN = 0.0312f;
+const float SUBPIXEL_QUALITY = 0.75f;
+// Steps of the search along the edge in both directions
+const int SEARCH_STEPS = 12;
+const float SEARCH_STEP_SIZES[SEARCH_STEPS] = float[](1.0f, 1.0f, 1.0f, 1.0f, 1.0f, 1.5f, 2.0f, 2.0f, 2.0f, 2.0f, 4.0f, 8.0f);
+
+// Texels outside a scaled viewport are stale, keep the bilinear footprint inside it
+vec3 Sample(vec2 uv)
+{
+	return textureLod(source, clamp(uv, 0.5f * inverseSourceSize, sourceScale - 0.5f * inverseSourceSize), 0.0f).rgb;
+}
+
+float Luma(vec2 uv)
+{
+	return dot(Sample(uv), vec3(0.299f, 0.587f, 0.114f));
+}
+
+float Luma(vec2 uv, ivec2 offset)
+{
+	return Luma(uv + vec2(offset) * inverseSourceSize);
+}
+
+void main()
+{
+	// The window may be larger or smaller than the source
+	vec2 uv = gl_FragCoord.xy * inverseTargetSize * sourceScale;
+
+	vec3 color = Sample(uv);
+	if (!antiAliasing)
+	{
+		FragColor = vec4(color, 1.0f);
+		return;
+	}
+
+	float lumaCenter = dot(color, vec3(0.299f, 0.587f, 0.114f));
+	float lumaDown = Luma(uv, ivec2(0, -1));
+	float lumaUp = Luma(uv, ivec2(0, 1));
+	float lumaLeft = Luma(uv, ivec2(-1, 0));
+	float lumaRight = Luma(uv, ivec2(1, 0));
+
+	float lumaMin = min(lumaCenter, min(min(lumaDown, lumaUp), min(lumaLeft, lumaRight)));
+	float lumaMax = max(lumaCenter, max(max(lumaDown, lumaUp), max(lumaLeft, lumaRight)));
+	float lumaRange = lumaMax - lumaMin;
+	if (lumaRange < max(EDGE_THRESHOLD_MIN, lumaMax * EDGE_THRESHOLD))
+	{
+		FragColor = vec4(color, 1.0f);
+		return;
+	}
+
+	float lumaDownLeft = Luma(uv, ivec2(-1, -1));
+	float lumaUpRight = Luma(uv, ivec2(1, 1));
+	float lumaUpLeft = Luma(uv, ivec2(-1, 1));
+	float lumaDownRight = Luma(uv, ivec2(1, -1));
+
+	float lumaDownUp = lumaDown + lumaUp;
+	float lumaLeftRight = lumaLeft + lumaRight;
+	float lumaLeftCorners = lumaDownLeft + lumaUpLeft;
+	float lumaDownCorners = lumaDownLeft + lumaDownRight;
+	float lumaRightCorners = lumaDownRight + lumaUpRight;
+	float lumaUpCorners = lumaUpRight + lumaUpLeft;
+
+	// Horizontal edges have a strong vertical gradient
+	float edgeHorizontal = abs(-2.0f * lumaLeft + lumaLeftCorners) + abs(-2.0f * lumaCenter + lumaDownUp) * 2.0f + abs(-2.0f * lumaRight + lumaRightCorners);
+	float edgeVertical = abs(-2.0f * lumaUp + lumaUpCorners) + abs(-2.0f * lumaCenter + lumaLeftRight) * 2.0f + abs(-2.0f * lumaDown + lumaDownCorners);
+	bool isHorizontal = edgeHorizontal >= edgeVertical;
+
+	// Pick the side of the pixel the edge lies on
+	float luma1 = isHorizontal ? lumaDown : lumaLeft;
+	float luma2 = isHorizontal ? lumaUp : lumaRight;
+	float gradient1 = luma1 - lumaCenter;
+	float gradient2 = luma2 - lumaCenter;
+	bool isSide1Steeper = abs(gradient1) >= abs(gradient2);
+	float gradientScaled = 0.25f * max(abs(gradient1), abs(gradient2));
+
+	float stepLength = isHorizontal ? inverseSourceSize.y : inverseSourceSize.x;
+	float lumaLocalAverage;
+	if (isSide1Steeper)
+	{
+		stepLength = -stepLength;
+		lumaLocalAverage = 0.5f * (luma1 + lumaCenter);
+	}
+	else
+		lumaLocalAverage = 0.5f * (luma2 + lumaCenter);
+
+	// Start half a pixel towards the edge and walk along it in both directions until its end
+	vec2 currentUv = uv;
+	if (isHorizontal)
+		currentUv.y += stepLength * 0.5f;
+	else
+		currentUv.x += stepLength * 0.5f;
+
+	vec2 offset = isHorizontal ? vec2(inverseSourceSize.x, 0.0f) : vec2(0.0f, inverseSourceSize.y);
+	vec2 uv1 = currentUv - offset;
+	vec2 uv2 = currentUv + offset;
+	float lumaEnd1 = Luma(uv1) - lumaLocalAverage;
+	float lumaEnd2 = Luma(uv2) - lumaLocalAverage;
+	bool reached1 = abs(lumaEnd1) >= gradientScaled;
+	bool reached2 = abs(lumaEnd2) >= gradientScaled;
+
+	for (int i = 1; i < SEARCH_STEPS && !(reached1 && reached2); ++i)
+	{
+		if (!reached1)
+		{
+			uv1 -= offset * SEARCH_STEP_SIZES[i];
+			lumaEnd1 = Luma(uv1) - lumaLocalAverage;
+			reached1 = abs(lumaEnd1) >= gradientScaled;
+		}
+		if (!reached2)
+		{
+			uv2 += offset * SEARCH_STEP_SIZES[i];
+			lumaEnd2 = Luma(uv2) - lumaLocalAverage;
+			reached2 = abs(lumaEnd2) >= gradientScaled;
+		}
+	}
+
+	float distance1 = isHorizontal ? (uv.x - uv1.x) : (uv.y - uv1.y);
+	float distance2 = isHorizontal ? (uv2.x - uv.x) : (uv2.y - uv.y);
+	bool isDirection1 = distance1 < distance2;
+	float distanceFinal = min(distance1, distance2);
+	float edgeLength = distance1 + distance2;
+
+	// Only blend if the closer end agrees with the variation at the center
+	bool isLumaCenterSmaller = lumaCenter < lumaLocalAverage;
+	bool correctVariation = ((isDirection1 ? lumaEnd1 : lumaEnd2) < 0.0f) != isLumaCenterSmaller;
+	float pixelOffset = correctVariation ? -distanceFinal / edgeLength + 0.5f : 0.0f;
+
+	// Sub-pixel aliasing, e.g. thin lines, from the 3x3 neighbourhood
+	float lumaAverage = (1.0f / 12.0f) * (2.0f * (lumaDownUp + lumaLeftRight) + lumaLeftCorners + lumaRightCorners);
+	float subPixelOffset1 = clamp(abs(lumaAverage - lumaCenter) / lumaRange, 0.0f, 1.0f);
+	float subPixelOffset2 = (-2.0f * subPixelOffset1 + 3.0f) * subPixelOffset1 * subPixelOffset1;
+	float subPixelOffset = subPixelOffset2 * subPixelOffset2 * SUBPIXEL_QUALITY;
+	pixelOffset = max(pixelOffset, subPixelOffset);
+
+	vec2 finalUv = uv;
+	if (isHorizontal)
+		finalUv.y += pixelOffset * stepLength;
+	else
+		finalUv.x += pixelOffset * stepLength;
+
+	FragColor = vec4(Sample(finalUv), 1.0f);
+}
@@ -1,4 +1,4 @@
-#version 330 core
+#version 430 core
 layout(location = 0) in vec2 position;
 
 struct Noise
@@ -14,6 +14,12 @@ uniform int isoLevel = 0;
 uniform sampler3D densityTex;
 uniform Noise noise[4];
 uniform float noiseScale = 1;
+uniform bool collectStatistics = false;
+
+layout(std430, binding = 3) buffer McStatistics
+{
+	uint caseHistogram[256];
+};
 
 out Gridcell {
    vec3 p[8];
@@ -82,5 +88,8 @@ void main()
       //TODO: Code something smart
 	}
 
+	if (collectStatistics)
+		atomicAdd(caseHistogram[cubeindex], 1u);
+
 	vs_out.mc_case = cubeindex;
 }
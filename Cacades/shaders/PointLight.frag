@@ -12,9 +12,9 @@ void main()
 	float lightDistance = length(FragPos.xyz - lightPos);
 
 	// map to [0;1] range by dividing by far_plane
-	//lightDistance /= far_plane;
+	lightDistance /= far_plane;
 
-	// Write this as modified depth
-	gl_FragDepth = lightDistance / far_plane;
+	// Write this as modified depth, moments are only stored for VSM shadows
+	gl_FragDepth = lightDistance;
 	varianceShadowMap = vec2(lightDistance, lightDistance * lightDistance);
-}
+}
\ No newline at end of file
@@ -0,0 +1,29 @@
+#version 430 core
+#extension GL_ARB_shader_viewport_layer_array : enable
+layout(location = 0) in vec3 position;
+
+uniform mat4 model;
+uniform mat4 shadowMatrices[6];
+// Cube faces this draw covers, one instance per set bit
+uniform int layerMask = 1;
+
+out vec4 FragPos;
+
+void main()
+{
+	// Face of the n-th set bit of layerMask, n being the instance
+	int face = 0;
+	for (int n = gl_InstanceID; face < 6; ++face)
+	{
+		if ((layerMask & (1 << face)) != 0 && n-- == 0)
+			break;
+	}
+
+	FragPos = model * vec4(position, 1.0f);
+	gl_Position = shadowMatrices[face] * FragPos;
+
+#ifdef GL_ARB_shader_viewport_layer_array
+	// Without the extension every draw covers a single face and sets its own viewport
+	gl_ViewportIndex = face;
+#endif
+}
\ No newline at end of file
@@ -0,0 +1,25 @@
+#version 430 core
+layout(location = 0) in vec3 position;
+
+uniform mat4 model;
+uniform vec3 lightPos;
+uniform float near_plane;
+uniform float far_plane;
+// 1 renders the hemisphere facing -z, -1 the one facing +z
+uniform float hemisphere = 1.0f;
+// How far past the seam each half extends, keeps triangles crossing it from leaving a gap
+uniform float overlap = 0.05f;
+
+out vec4 FragPos;
+
+void main()
+{
+	FragPos = model * vec4(position, 1.0f);
+
+	vec3 toFragment = FragPos.xyz - lightPos;
+	float lightDistance = length(toFragment);
+	vec3 direction = vec3(hemisphere * toFragment.x, toFragment.y, -hemisphere * toFragment.z) / lightDistance;
+
+	gl_ClipDistance[0] = direction.z + overlap;
+	gl_Position = vec4(direction.xy / (1.0f + direction.z), (lightDistance - near_plane) / (far_plane - near_plane) * 2.0f - 1.0f, 1.0f);
+}
\ No newline at end of file
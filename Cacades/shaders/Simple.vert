@@ -1,12 +1,11 @@
-#version 330 core
+#version 430 core
 layout(location = 0) in vec3 position;
 layout(location = 1) in vec3 normal;
 layout(location = 2) in vec2 uv;
 layout(location = 3) in vec3 tangent;
 
 uniform mat4 model;
-uniform mat4 view;
-uniform mat4 projection;
+#pragma include "FrameData.glh"
 
 void main()
 {
@@ -5,19 +5,19 @@ in vec3 gFacetNormal;
 in vec3 gTriDistance;
 in vec3 gPatchDistance;
 
-out vec4 FragColor;
+layout(location = 0) out vec4 FragColor;
 
 #pragma include "EnumLightType.glh"
 #pragma include "EnumShadowMode.glh"
+#pragma include "EnumPointShadowMode.glh"
+#pragma include "FrameData.glh"
 #pragma include "Lighting.glh"
+#pragma include "GBuffer.glh"
 
-const int LIGHT_COUNT = 5;
-uniform LightSource Lights[LIGHT_COUNT];
 uniform int ShadowType = HARD_SHADOWS;
 uniform bool EnableLighting = true;
 
 uniform vec3 objectColor = vec3(1);
-uniform vec3 viewPos;
 
 float amplify(float d, float scale, float offset)
 {
@@ -29,31 +29,23 @@ float amplify(float d, float scale, float offset)
 
 void main()
 {
+	float d1 = min(min(gTriDistance.x, gTriDistance.y), gTriDistance.z);
+	float d2 = min(min(gPatchDistance.x, gPatchDistance.y), gPatchDistance.z);
+	float wireframe = amplify(d1, 40, -0.5) * amplify(d2, 60, -0.5);
+
+    if (WriteGBuffer)
+    {
+        StoreGBuffer(wireframe * objectColor, gFacetNormal, EnableLighting);
+        return;
+    }
+
     vec3 lighting;
 
     if (EnableLighting)
     {
         LightingGlobals globals = LightingGlobals(viewPos, gPosition, gFacetNormal, EnableLighting);
 
-    	lighting = vec3(0.0f, 0.0f, 0.0f);
-    	for (int i = 0; i < LIGHT_COUNT; i++)
-    	{
-    		if (!Lights[i].IsEnabled)
-    			continue;
-
-    		switch (Lights[i].Type)
-    		{
-    			case DIR_LIGHT:
-    			lighting += CalculateDirLightSource(Lights[i], globals);
-    			break;
-    			case SPOT_LIGHT:
-    			lighting += CalculateSpotLightSource(Lights[i], globals);
-    			break;
-    			case POINT_LIGHT:
-    			lighting += CalculatePointLightSource(Lights[i], globals);
-    			break;
-    		}
-    	}
+    	lighting = CalculateLightSources(globals);
         lighting = clamp(lighting, 0, 1);
         lighting *= objectColor;
     }
@@ -62,8 +54,6 @@ void main()
         lighting = objectColor;
     }
 
-	float d1 = min(min(gTriDistance.x, gTriDistance.y), gTriDistance.z);
-	float d2 = min(min(gPatchDistance.x, gPatchDistance.y), gPatchDistance.z);
-	lighting = amplify(d1, 40, -0.5) * amplify(d2, 60, -0.5) * lighting;
+	lighting = wireframe * lighting;
 	FragColor = vec4(lighting, 1.0f);
 }
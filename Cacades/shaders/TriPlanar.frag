@@ -1,96 +1,73 @@
-#version 330 core
+#version 430 core
 
-out vec4 FragColor;
+layout(location = 0) out vec4 FragColor;
 
 #pragma include "EnumLightType.glh"
 #pragma include "EnumShadowMode.glh"
+#pragma include "EnumPointShadowMode.glh"
+#pragma include "FrameData.glh"
 #pragma include "Lighting.glh"
+#pragma include "GBuffer.glh"
+#pragma include "Parallax.glh"
 
 in VS_OUT
 {
 	vec3 FragPos;
 	vec3 Normal;
 	vec3 UVW;
+	vec3 Blend;
 	mat3 TBN;
 } fs_in;
 
-const int LIGHT_COUNT = 5;
-
-uniform LightSource Lights[LIGHT_COUNT];
-
 uniform int ShadowType = HARD_SHADOWS;
 uniform bool EnableLighting = true;
 
-uniform sampler2D objectTexture[3];
-
-uniform sampler2D normalMap[3];
-uniform float bumbiness = 1f;
-
-uniform sampler2D displacementMap[3];
-uniform int displacement_initialSteps = 8;
-uniform int displacement_refinementSteps = 8;
-uniform float displacement_scale = 0.025f;
+// One layer per material, shared by all projections
+uniform sampler2DArray albedoMaps;
+uniform sampler2DArray normalMaps;
+uniform sampler2DArray heightMaps;
+// Material layer of the x, y and z projection
+uniform ivec3 projectionMaterials = ivec3(0);
 
-uniform vec3 viewPos;
-
-vec2 Parallax(sampler2D map, vec2 texCoords, vec3 viewDir)
+vec2 Parallax(int layer, vec2 texCoords, vec3 viewDir, vec2 dx, vec2 dy)
 {
-    return texCoords;
-
-    // calculate the size of each layer
-    float layerDepth = 1.0 / displacement_initialSteps;
-    // depth of current layer
-    float currentLayerDepth = 0.0;
-    // the amount to shift the texture coordinates per layer (from vector P)
-    vec2 P = vec2(viewDir.x, -viewDir.y) / viewDir.z * displacement_scale;
-    vec2 deltaTexCoords = P / displacement_initialSteps;
-
-    // get initial values
-    vec2  currentTexCoords     = texCoords;
-    float currentDepthMapValue = texture(map, currentTexCoords).r;
-
- 	while(currentLayerDepth < currentDepthMapValue)
+    float fade = ParallaxFade(distance(viewPos, fs_in.FragPos));
+    if (fade == 0.0f)
+        return texCoords;
+
+    vec2 offset = ParallaxOffset(viewDir);
+    int steps = ParallaxSteps(offset, dx, dy);
+    float layerDepth = 1.0f / steps;
+    vec2 deltaTexCoords = offset / steps;
+
+    // Linear search for the first layer below the height field
+    float currentLayerDepth = 0.0f;
+    vec2 currentTexCoords = texCoords;
+    float currentDepthMapValue = textureGrad(heightMaps, vec3(currentTexCoords, layer), dx, dy).r;
+    for (int i = 0; i < steps && currentLayerDepth < currentDepthMapValue; ++i)
     {
-        // shift texture coordinates along direction of P
         currentTexCoords -= deltaTexCoords;
-        // get depthmap value at current texture coordinates
-        currentDepthMapValue = texture(map, currentTexCoords).r;
-        // get depth of next layer
+        currentDepthMapValue = textureGrad(heightMaps, vec3(currentTexCoords, layer), dx, dy).r;
         currentLayerDepth += layerDepth;
     }
 
-    currentTexCoords += deltaTexCoords;
-    currentDepthMapValue = texture(map, currentTexCoords).r;
-    currentLayerDepth -= layerDepth;
-	currentLayerDepth -= 0.085f; //reduces artifacts
-
-	// decrease the step size as we do the refinement steps
-	deltaTexCoords /= displacement_refinementSteps;
-	layerDepth /= displacement_refinementSteps;
-
- 	while(currentLayerDepth < currentDepthMapValue)
+    // Binary search between the last two layers
+    for (int i = 0; i < displacement_refinementSteps; ++i)
     {
-        // shift texture coordinates along direction of P
-        currentTexCoords -= deltaTexCoords;
-        // get depthmap value at current texture coordinates
-        currentDepthMapValue = texture(map, currentTexCoords).r;
-        // get depth of next layer
-        currentLayerDepth += layerDepth;
+        float difference = currentDepthMapValue - currentLayerDepth;
+        if (abs(difference) < PARALLAX_EPSILON)
+            break;
+
+        // Above the height field continue inwards, below it back out
+        float direction = difference > 0.0f ? 1.0f : -1.0f;
+        deltaTexCoords *= 0.5f;
+        layerDepth *= 0.5f;
+        currentTexCoords -= direction * deltaTexCoords;
+        currentLayerDepth += direction * layerDepth;
+        currentDepthMapValue = textureGrad(heightMaps, vec3(currentTexCoords, layer), dx, dy).r;
     }
 
-    // get texture coordinates before collision (reverse operations)
-    vec2 prevTexCoords = currentTexCoords + deltaTexCoords;
-	float prevLayerDepth = currentLayerDepth - layerDepth;
-
-    // get depth after and before collision for linear interpolation
-    float afterDepth  = currentDepthMapValue - currentLayerDepth;
-    float beforeDepth = texture(map, prevTexCoords).r - prevLayerDepth;
-
-    // interpolation of texture coordinates
-    float weight = afterDepth / (afterDepth - beforeDepth);
-    vec2 finalTexCoords = prevTexCoords * weight + currentTexCoords * (1.0 - weight);
-
-    return finalTexCoords;
+    return mix(texCoords, currentTexCoords, fade);
 }
 
 vec3 NormalizeNormal(vec3 tmpNormal)
@@ -101,12 +78,22 @@ vec3 NormalizeNormal(vec3 tmpNormal)
   return normalize(tmpNormal * vec3(bumbiness, bumbiness, 1.0f));
 }
 
+vec3 CullBlendWeights(vec3 blending)
+{
+    bool dominantOnly = DominantAxisDistance > 0 && distance(viewPos, fs_in.FragPos) > DominantAxisDistance;
+    float maxWeight = max(blending.x, max(blending.y, blending.z));
+    float threshold = dominantOnly ? maxWeight : BlendThreshold;
+
+    // The dominant projection always survives, so the sum never becomes 0
+    blending *= step(vec3(min(threshold, maxWeight)), blending);
+    return blending / (blending.x + blending.y + blending.z);
+}
+
 void main()
 {
-    vec3 blending = abs( fs_in.Normal );
-    blending = normalize(max(blending, 0.00001)); // Force weights to sum to 1.0
-    float b = (blending.x + blending.y + blending.z);
-    blending /= vec3(b, b, b);
+    vec3 blending = CullBlendWeights(fs_in.Blend);
+    // Only the dominant projection is displaced, the others keep their plain coordinates
+    int dominant = blending.x >= blending.y ? (blending.x >= blending.z ? 0 : 2) : (blending.y >= blending.z ? 1 : 2);
 
 	mat3 AntiTBN = transpose(fs_in.TBN);
 	vec3 tangentViewDir = normalize((AntiTBN * viewPos) - (AntiTBN * fs_in.FragPos));
@@ -120,9 +107,20 @@ void main()
     vec3[3] normals;
     for (int i = 0; i < 3; ++i)
     {
-        uvs[i] = Parallax(displacementMap[i], uvs[i], tangentViewDir);
-        colors[i] = texture(objectTexture[i], uvs[i]).xyz;
-        normals[i] = NormalizeNormal(texture(normalMap[i], uvs[i]).xyz);
+        colors[i] = vec3(0);
+        normals[i] = vec3(0);
+
+        // Gradients have to be taken outside of the non-uniform branch below
+        vec2 dx = dFdx(uvs[i]);
+        vec2 dy = dFdy(uvs[i]);
+        if (blending[i] == 0)
+            continue;
+
+        int layer = projectionMaterials[i];
+        if (i == dominant)
+            uvs[i] = Parallax(layer, uvs[i], tangentViewDir, dx, dy);
+        colors[i] = textureGrad(albedoMaps, vec3(uvs[i], layer), dx, dy).xyz;
+        normals[i] = NormalizeNormal(textureGrad(normalMaps, vec3(uvs[i], layer), dx, dy).xyz);
     }
 
     vec3 color = colors[0] * blending[0] + colors[1] * blending[1] + colors[2] * blending[2];
@@ -130,6 +128,12 @@ void main()
     vec3 normal = fs_in.Normal;//normals[0] * blending[0] + normals[1] * blending[1] + normals[2] * blending[2];
     //normal = transpose(fs_in.TBN) * normal;
 
+	if (WriteGBuffer)
+	{
+		StoreGBuffer(color, fs_in.Normal, EnableLighting && normal != vec3(0.0f));
+		return;
+	}
+
 	if (!EnableLighting || normal == vec3(0.0f))
 	{
 		FragColor = vec4(color, 1.0f);
@@ -138,25 +142,7 @@ void main()
 
 	LightingGlobals globals = LightingGlobals(viewPos, fs_in.FragPos, fs_in.Normal, EnableLighting);
 
-	vec3 lighting = vec3(0.0f, 0.0f, 0.0f);
-	for (int i = 0; i < LIGHT_COUNT; i++)
-	{
-		if (!Lights[i].IsEnabled)
-			continue;
-
-		switch (Lights[i].Type)
-		{
-		case DIR_LIGHT:
-			lighting += CalculateDirLightSource(Lights[i], globals);
-			break;
-		case SPOT_LIGHT:
-			lighting += CalculateSpotLightSource(Lights[i], globals);
-			break;
-		case POINT_LIGHT:
-			lighting += CalculatePointLightSource(Lights[i], globals);
-			break;
-		}
-	}
+	vec3 lighting = CalculateLightSources(globals);
 
 	lighting = clamp(lighting, 0, 1);
 	lighting *= color;
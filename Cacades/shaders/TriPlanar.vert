@@ -1,4 +1,4 @@
-#version 330 core
+#version 430 core
 layout(location = 0) in vec3 position;
 layout(location = 1) in vec3 normal;
 layout(location = 2) in vec3 uvw;
@@ -8,12 +8,12 @@ out VS_OUT
     vec3 FragPos;
     vec3 Normal;
     vec3 UVW;
+    vec3 Blend;
     mat3 TBN;
 } vs_out;
 
 uniform mat4 model;
-uniform mat4 view;
-uniform mat4 projection;
+#pragma include "FrameData.glh"
 
 void main()
 {
@@ -22,6 +22,10 @@ void main()
     vs_out.Normal = normalize(vec3(transpose(inverse(model)) * vec4(normal, 1.0f)));
     vs_out.UVW = uvw;
 
+    // Projection weights, computed once per vertex instead of per fragment
+    vec3 blending = max(abs(vs_out.Normal), 0.00001);
+    vs_out.Blend = blending / (blending.x + blending.y + blending.z);
+
     vec3 tangent = vec3(1, 0, 0);
     vec3 binormal = normalize(cross(tangent, vs_out.Normal));
     tangent = normalize(cross(vs_out.Normal, binormal));
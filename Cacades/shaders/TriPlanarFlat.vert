@@ -0,0 +1,38 @@
+#version 430 core
+layout(location = 0) in vec3 position;
+layout(location = 1) in vec3 normal;
+layout(location = 2) in vec3 uvw;
+
+out VS_OUT
+{
+    vec3 FragPos;
+    vec3 Normal;
+    vec3 UVW;
+    vec3 Blend;
+    mat3 TBN;
+} vs_out;
+
+uniform mat4 model;
+#pragma include "FrameData.glh"
+
+// Untessellated variant for distant slabs, the depth pre-pass (DepthOnly.vert) has to produce the same depth
+invariant gl_Position;
+
+void main()
+{
+	gl_Position = projection * view *  model * vec4(position, 1.0f);
+    vs_out.FragPos = vec3(model * vec4(position, 1.0f));
+    vs_out.Normal = normalize(vec3(transpose(inverse(model)) * vec4(normal, 1.0f)));
+    vs_out.UVW = uvw;
+
+    // Projection weights, computed once per vertex instead of per fragment
+    vec3 blending = max(abs(vs_out.Normal), 0.00001);
+    vs_out.Blend = blending / (blending.x + blending.y + blending.z);
+
+    vec3 tangent = vec3(1, 0, 0);
+    vec3 binormal = normalize(cross(tangent, vs_out.Normal));
+    tangent = normalize(cross(vs_out.Normal, binormal));
+    mat3 TBN = transpose(mat3(tangent, binormal, vs_out.Normal));
+
+  	vs_out.TBN = TBN;
+}
@@ -1,11 +1,12 @@
-#version 330 core
+#version 430 core
 
-out vec4 FragColor;
+layout(location = 0) out vec4 FragColor;
 
 #line 1 1 
 #pragma include "EnumLightType.glh"
 #line 1 2
 #pragma include "EnumShadowMode.glh"
+#pragma include "EnumPointShadowMode.glh"
 #line 1 3
 #pragma include "EnumColorMode.glh"
 #line 1 4
@@ -13,7 +14,10 @@ out vec4 FragColor;
 #line 1 5
 #pragma include "EnumDisplacementMode.glh"
 #line 1 6
+#pragma include "FrameData.glh"
 #pragma include "Lighting.glh"
+#pragma include "GBuffer.glh"
+#pragma include "Parallax.glh"
 #line 17 0
 
 in VS_OUT
@@ -24,10 +28,6 @@ in VS_OUT
 	mat3 TBN;
 } fs_in;
 
-const int LIGHT_COUNT = 4;
-
-uniform LightSource Lights[LIGHT_COUNT];
-
 uniform int ShadowType = HARD_SHADOWS;
 uniform bool EnableLighting = true;
 
@@ -37,73 +37,53 @@ uniform sampler2D objectTexture;
 
 uniform int normalMode;
 uniform sampler2D normalMap;
-uniform float bumbiness = 2.0f;
 
 uniform int displacementMode;
 uniform sampler2D displacementMap;
-uniform int displacement_initialSteps;
-uniform int displacement_refinementSteps;
-uniform float displacement_scale = 0.025f;
-
-uniform vec3 viewPos;
 
 vec2 ParallaxMapping(vec2 texCoords, vec3 viewDir)
-{ 
-    // calculate the size of each layer
-    float layerDepth = 1.0 / displacement_initialSteps;
-    // depth of current layer
-    float currentLayerDepth = 0.0;
-    // the amount to shift the texture coordinates per layer (from vector P)
-    vec2 P = vec2(viewDir.x, -viewDir.y) / viewDir.z * displacement_scale; 
-    vec2 deltaTexCoords = P / displacement_initialSteps;
-  
-    // get initial values
-    vec2  currentTexCoords     = texCoords;
-    float currentDepthMapValue = texture(displacementMap, currentTexCoords).r;
-
- 	while(currentLayerDepth < currentDepthMapValue)
+{
+    vec2 dx = dFdx(texCoords);
+    vec2 dy = dFdy(texCoords);
+
+    float fade = ParallaxFade(distance(viewPos, fs_in.FragPos));
+    if (fade == 0.0f)
+        return texCoords;
+
+    vec2 offset = ParallaxOffset(viewDir);
+    int steps = ParallaxSteps(offset, dx, dy);
+    float layerDepth = 1.0f / steps;
+    vec2 deltaTexCoords = offset / steps;
+
+    // Linear search for the first layer below the height field
+    float currentLayerDepth = 0.0f;
+    vec2 currentTexCoords = texCoords;
+    float currentDepthMapValue = textureGrad(displacementMap, currentTexCoords, dx, dy).r;
+    for (int i = 0; i < steps && currentLayerDepth < currentDepthMapValue; ++i)
     {
-        // shift texture coordinates along direction of P
         currentTexCoords -= deltaTexCoords;
-        // get depthmap value at current texture coordinates
-        currentDepthMapValue = texture(displacementMap, currentTexCoords).r;  
-        // get depth of next layer
-        currentLayerDepth += layerDepth;  
+        currentDepthMapValue = textureGrad(displacementMap, currentTexCoords, dx, dy).r;
+        currentLayerDepth += layerDepth;
     }
-	
-    currentTexCoords += deltaTexCoords;
-    currentDepthMapValue = texture(displacementMap, currentTexCoords).r;  
-    currentLayerDepth -= layerDepth;  
-	currentLayerDepth -= 0.085f; //reduces artifacts
-
-	// decrease the step size as we do the refinement steps
-	deltaTexCoords /= displacement_refinementSteps;
-	layerDepth /= displacement_refinementSteps;
-	
- 	while(currentLayerDepth < currentDepthMapValue)
+
+    // Binary search between the last two layers
+    for (int i = 0; i < displacement_refinementSteps; ++i)
     {
-        // shift texture coordinates along direction of P
-        currentTexCoords -= deltaTexCoords;
-        // get depthmap value at current texture coordinates
-        currentDepthMapValue = texture(displacementMap, currentTexCoords).r;  
-        // get depth of next layer
-        currentLayerDepth += layerDepth;  
+        float difference = currentDepthMapValue - currentLayerDepth;
+        if (abs(difference) < PARALLAX_EPSILON)
+            break;
+
+        // Above the height field continue inwards, below it back out
+        float direction = difference > 0.0f ? 1.0f : -1.0f;
+        deltaTexCoords *= 0.5f;
+        layerDepth *= 0.5f;
+        currentTexCoords -= direction * deltaTexCoords;
+        currentLayerDepth += direction * layerDepth;
+        currentDepthMapValue = textureGrad(displacementMap, currentTexCoords, dx, dy).r;
     }
-    
-    // get texture coordinates before collision (reverse operations)
-    vec2 prevTexCoords = currentTexCoords + deltaTexCoords;
-	float prevLayerDepth = currentLayerDepth - layerDepth; 
-
-    // get depth after and before collision for linear interpolation
-    float afterDepth  = currentDepthMapValue - currentLayerDepth;
-    float beforeDepth = texture(displacementMap, prevTexCoords).r - prevLayerDepth;
- 
-    // interpolation of texture coordinates
-    float weight = afterDepth / (afterDepth - beforeDepth);
-    vec2 finalTexCoords = prevTexCoords * weight + currentTexCoords * (1.0 - weight);
-
-    return finalTexCoords;
-} 
+
+    return mix(texCoords, currentTexCoords, fade);
+}
 
 vec2 DetermineTextureCoords(vec2 uv)
 {
@@ -168,6 +148,12 @@ void main()
 
 	vec3 normal = DetermineFragmentNormal(normalMode, texCoords);
 
+	if (WriteGBuffer)
+	{
+		StoreGBuffer(color, normal, EnableLighting && normal != vec3(0.0f));
+		return;
+	}
+
 	if (!EnableLighting || normal == vec3(0.0f))
 	{
 		FragColor = vec4(color, 1.0f);
@@ -176,25 +162,7 @@ void main()
 
 	LightingGlobals globals = LightingGlobals(viewPos, fs_in.FragPos, normal, EnableLighting);
 
-	vec3 lighting = vec3(0.0f, 0.0f, 0.0f);
-	for (int i = 0; i < LIGHT_COUNT; i++)
-	{
-		if (!Lights[i].IsEnabled)
-			continue;
-
-		switch (Lights[i].Type)
-		{
-		case DIR_LIGHT:
-			lighting += CalculateDirLightSource(Lights[i], globals);
-			break;
-		case SPOT_LIGHT:
-			lighting += CalculateSpotLightSource(Lights[i], globals);
-			break;
-		case POINT_LIGHT:
-			lighting += CalculatePointLightSource(Lights[i], globals);
-			break;
-		}
-	}
+	vec3 lighting = CalculateLightSources(globals);
 
 	lighting = clamp(lighting, 0, 1);
 	lighting *= color;
@@ -1,4 +1,4 @@
-#version 330 core
+#version 430 core
 layout(location = 0) in vec3 position;
 layout(location = 1) in vec3 normal;
 layout(location = 2) in vec2 uv;
@@ -13,8 +13,10 @@ out VS_OUT
 } vs_out;
 
 uniform mat4 model;
-uniform mat4 view;
-uniform mat4 projection;
+#pragma include "FrameData.glh"
+
+// The depth pre-pass (DepthOnly.vert) has to produce the same depth
+invariant gl_Position;
 
 void main()
 {